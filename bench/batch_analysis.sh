@@ -0,0 +1,45 @@
+#!/bin/sh
+# Analyses a generated spec of many functions (mostly small, a few large)
+# in one batch and reports the throughput and the peak graph memory, which
+# stays that of the largest function since memory is reused from one
+# function to the next (of each worker thread). The arena, which is reset
+# between functions, keeps its blocks, so its reserved memory stays close
+# to its high water mark.
+#
+# The batch is analysed with each of the given numbers of threads; the
+# wall-clock rate is the one to compare, the parse and analysis times
+# being summed over threads.
+#
+# Usage: bench/batch_analysis.sh <build-dir> [functions] [max-blocks]
+#                                [threads...]
+set -e
+
+BUILD=${1:-build}
+F=${2:-5000}
+N=${3:-1000}
+shift $(( $# < 3 ? $# : 3 ))
+THREADS=${*:-1 2 4 8}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$BUILD/gen-cfg" -f $F -n $N -k random -r > "$TMP/cfg"
+
+for j in $THREADS; do
+  "$BUILD/ibn-khaldun" -s -e auto -j $j "$TMP/cfg" 2> "$TMP/stats" > /dev/null
+  echo "threads:  $j"
+  awk '
+    /^parse:/ { parse = $2; blocks = $4 }
+    /^graph:/ { graph = $2 }
+    /^arena:/ { arena = $2; reserved = $6 }
+    /^analysis:/ { analysis = $2 }
+    /^cfgs:/ { cfgs = $2; wall = $4 }
+    END {
+      printf "cfgs:     %d (%d blocks)\n", cfgs, blocks
+      printf "parse:    %.1f ms\n", parse
+      printf "analysis: %.1f ms\n", analysis
+      printf "wall:     %.1f ms\n", wall
+      printf "rate:     %.0f cfgs/s\n", cfgs / (wall / 1e3)
+      printf "peak:     %d bytes of graph memory\n", graph
+      printf "arena:    %d bytes high water, %d bytes reserved\n", arena, reserved
+    }' "$TMP/stats"
+done
@@ -0,0 +1,110 @@
+// Measures the throughput of the bitset kernels used by the iterative
+// dominance engine for every kernel implementation the CPU supports.
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/bitset.h"
+#include "bench_util.h"
+
+// Roughly how many bytes every measurement streams through the kernels.
+#define BYTES_PER_MEASUREMENT (1ull << 31)
+
+static void fill_random(BitsetWord *set, size_t numWords) {
+  for (size_t i=0 ; i<numWords ; i++) {
+    set[i] = bench_random() | 0x8000000000000001ull;
+  }
+}
+
+/// Reports the throughput of bitset_and and bitset_equal on sets of
+/// numBits bits with the currently selected kernels. Throughput counts the
+/// bytes of both operands.
+static void bench_width(size_t numBits) {
+  size_t numWords = bitset_num_words(numBits);
+  size_t bytesPerOp = 2 * numWords * sizeof(BitsetWord);
+  size_t reps = BYTES_PER_MEASUREMENT / bytesPerOp;
+  BitsetWord *a = malloc(numWords * sizeof(BitsetWord));
+  BitsetWord *b = malloc(numWords * sizeof(BitsetWord));
+
+  fill_random(a, numWords);
+  fill_random(b, numWords);
+  // Make a a subset of b so repeated intersections keep a stable.
+  bitset_and(a, b, numWords);
+
+  double start = bench_time_s();
+  for (size_t r=0 ; r<reps ; r++) {
+    bitset_and(a, b, numWords);
+  }
+  double andTime = bench_time_s() - start;
+
+  memcpy(a, b, numWords * sizeof(BitsetWord));
+  int numEqual = 0;
+  start = bench_time_s();
+  for (size_t r=0 ; r<reps ; r++) {
+    numEqual += bitset_equal(a, b, numWords);
+  }
+  double equalTime = bench_time_s() - start;
+
+  printf("%-8s %10zu %12.2f %12.2f%s\n",
+         bitset_impl_name(bitset_current_impl()), numBits,
+         reps * bytesPerOp / andTime / 1e9,
+         reps * bytesPerOp / equalTime / 1e9,
+         (size_t)numEqual == reps ? "" : "  (WRONG RESULT)");
+
+  free(a);
+  free(b);
+}
+
+/// Cross-checks the results of the current kernels against the scalar
+/// ones for all set sizes up to a few vectors, which covers every tail.
+static int check_impl(BitsetImpl impl) {
+  BitsetWord a[64], b[64], expected[64];
+
+  for (size_t numWords=0 ; numWords<=64 ; numWords++) {
+    fill_random(a, numWords);
+    fill_random(b, numWords);
+    memcpy(expected, a, numWords * sizeof(BitsetWord));
+
+    bitset_use_impl(BITSET_IMPL_SCALAR);
+    bitset_and(expected, b, numWords);
+    bitset_use_impl(impl);
+    bitset_and(a, b, numWords);
+
+    if (memcmp(a, expected, numWords * sizeof(BitsetWord)) != 0
+        || !bitset_equal(a, expected, numWords)
+        || (numWords > 0 && bitset_equal(a, b, numWords)
+            != !memcmp(a, b, numWords * sizeof(BitsetWord)))) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+int main() {
+  static const size_t widths[] = { 1000, 64000, 1000000 };
+  static const BitsetImpl impls[] = {
+    BITSET_IMPL_SCALAR, BITSET_IMPL_AVX2, BITSET_IMPL_AVX512
+  };
+
+  printf("%-8s %10s %12s %12s\n", "kernel", "bits", "and GB/s", "equal GB/s");
+
+  for (size_t i=0 ; i<sizeof(impls)/sizeof(impls[0]) ; i++) {
+    if (!bitset_impl_supported(impls[i])) {
+      printf("%-8s not supported by this CPU\n", bitset_impl_name(impls[i]));
+      continue;
+    }
+
+    if (!check_impl(impls[i])) {
+      printf("%-8s results differ from the scalar kernels\n",
+             bitset_impl_name(impls[i]));
+      return 1;
+    }
+
+    for (size_t w=0 ; w<sizeof(widths)/sizeof(widths[0]) ; w++) {
+      bench_width(widths[w]);
+    }
+  }
+
+  return 0;
+}
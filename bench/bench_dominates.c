@@ -0,0 +1,168 @@
+// Measures dominance queries on analysed CFGs: cfg_context_dominates, which
+// compares preorder intervals of the dominator tree, against walking up the
+// IDOMs of one BB in search of the other, which is what answering a query
+// from the dominator sets amounts to. Both answer the same random queries,
+// and their answers must agree.
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/cfg.h"
+#include "bench_util.h"
+
+// Queries are generated in batches of this many, outside of the timing.
+#define QUERY_BATCH (1 << 20)
+// How long the IDOM walks may take per spec, as they take time linear in
+// the depth of the dominator tree.
+#define WALK_TIME_LIMIT_S 2.0
+
+/// Answers whether a dominates b by walking up the IDOMs of b.
+static int dominates_by_walk(const CFGContext *ctx, int a, int b) {
+  if (cfg_context_idom(ctx, a) == -1 || cfg_context_idom(ctx, b) == -1) {
+    return 0;
+  }
+
+  for (;;) {
+    if (b == a) {
+      return 1;
+    }
+    // The roots of the tree (or of a post-dominator forest).
+    if (cfg_context_idom(ctx, b) == b) {
+      return 0;
+    }
+    b = cfg_context_idom(ctx, b);
+  }
+}
+
+static void fill_queries(int *as, int *bs, int numQueries, int numBBs) {
+  for (int i=0 ; i<numQueries ; i++) {
+    as[i] = bench_random_below(numBBs);
+    bs[i] = bench_random_below(numBBs);
+  }
+}
+
+/// Runs numQueries random queries on the CFG of ctx with both methods and
+/// prints a table row. Returns 1 if the methods agreed.
+static int bench_queries(const char *path, const CFGContext *ctx,
+                         long numQueries, int *as, int *bs) {
+  int numBBs = cfg_context_num_bbs(ctx);
+  long numDominated = 0;
+  double time = 0;
+
+  for (long done=0 ; done<numQueries ; done+=QUERY_BATCH) {
+    int batch = numQueries - done < QUERY_BATCH
+      ? numQueries - done : QUERY_BATCH;
+
+    fill_queries(as, bs, batch, numBBs);
+
+    double start = bench_time_s();
+    for (int i=0 ; i<batch ; i++) {
+      numDominated += cfg_context_dominates(ctx, as[i], bs[i]);
+    }
+    time += bench_time_s() - start;
+  }
+
+  // The walks answer as many queries of the last batch as they can in
+  // WALK_TIME_LIMIT_S, and are checked against the intervals.
+  int batch = numQueries < QUERY_BATCH ? numQueries : QUERY_BATCH;
+  int numWalks = 0;
+  int ok = 1;
+  double walkStart = bench_time_s();
+  double walkTime = 0;
+
+  while (numWalks < batch) {
+    int i = numWalks++;
+
+    if (dominates_by_walk(ctx, as[i], bs[i])
+        != cfg_context_dominates(ctx, as[i], bs[i])) {
+      fprintf(stderr, "%s: queries disagree on whether BB %d dominates "
+              "BB %d\n", path, cfg_context_bb_id(ctx, as[i]),
+              cfg_context_bb_id(ctx, bs[i]));
+      ok = 0;
+      break;
+    }
+
+    if (numWalks % 1024 == 0) {
+      walkTime = bench_time_s() - walkStart;
+      if (walkTime > WALK_TIME_LIMIT_S) {
+        break;
+      }
+    }
+  }
+  walkTime = bench_time_s() - walkStart;
+
+  printf("%-24s %9d %11ld %9.2f %11ld %9d %10.1f  %s\n", path, numBBs,
+         numQueries, time * 1e9 / numQueries, numDominated, numWalks,
+         walkTime * 1e9 / numWalks, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-n queries] [-P] cfg-spec...\n", prog);
+}
+
+int main(int argc, char **argv) {
+  CFGOptions opts;
+  long numQueries = 100000000;
+  int opt;
+
+  memset(&opts, 0, sizeof(opts));
+  opts.engine = DOM_ENGINE_AUTO;
+  opts.autoEngineThreshold = DEFAULT_AUTO_ENGINE_THRESHOLD;
+  opts.parser = CFG_PARSER_SIMD;
+  opts.numThreads = 1;
+
+  while ((opt = getopt(argc, argv, "n:Ph")) != -1) {
+    switch (opt) {
+    case 'n':
+      numQueries = atol(optarg);
+      break;
+    case 'P':
+      opts.postDominators = 1;
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (optind == argc || numQueries < 1) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  int *as = malloc(QUERY_BATCH * sizeof(int));
+  int *bs = malloc(QUERY_BATCH * sizeof(int));
+  CFGContext *ctx = cfg_context_create(&opts);
+  int ok = 1;
+
+  printf("%-24s %9s %11s %9s %11s %9s %10s\n", "spec", "blocks", "queries",
+         "ns/query", "dominated", "walks", "ns/walk");
+
+  for (int i=optind ; i<argc ; i++) {
+    size_t size;
+    char *spec = bench_read_file(argv[i], &size);
+
+    if (spec == NULL) {
+      return 1;
+    }
+
+    if (!cfg_context_parse(ctx, spec, size)) {
+      fprintf(stderr, "%s: not a valid CFG\n", argv[i]);
+      return 1;
+    }
+    cfg_context_analyse(ctx, NULL);
+
+    if (cfg_context_num_bbs(ctx) > 0) {
+      ok &= bench_queries(argv[i], ctx, numQueries, as, bs);
+    }
+
+    free(spec);
+  }
+
+  cfg_context_destroy(ctx);
+  free(as);
+  free(bs);
+  return ok ? 0 : 1;
+}
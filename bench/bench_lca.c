@@ -0,0 +1,262 @@
+// Measures nearest common dominator queries with both kinds of LCA index:
+// the time and memory to build the index, the time of a query on a random
+// pair of BBs and of a query on a random set of BBs. The answers of both
+// indexes must agree with each other, with folding the pairs of a set, and,
+// for as many queries as fit in a few seconds, with climbing the IDOMs of
+// one BB until reaching a dominator of the other.
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/cfg.h"
+#include "bench_util.h"
+
+// Queries are generated in batches of this many, outside of the timing.
+#define QUERY_BATCH (1 << 20)
+// The number of BBs in the sets of the set queries.
+#define SET_SIZE 8
+// How long the checks by climbing the IDOMs may take per spec.
+#define CLIMB_TIME_LIMIT_S 2.0
+
+static const struct {
+  const char *name;
+  LCAIndexKind kind;
+} indexKinds[] = {
+  { "table", LCA_INDEX_SPARSE_TABLE },
+  { "jumps", LCA_INDEX_JUMP_POINTERS },
+};
+
+#define NUM_INDEX_KINDS (int)(sizeof(indexKinds) / sizeof(indexKinds[0]))
+
+/// Finds the nearest common dominator of a and b by climbing from a until
+/// reaching a dominator of b, or a root of a post-dominator forest that is
+/// not one.
+static int common_dominator_by_climbing(const CFGContext *ctx, int a, int b) {
+  if (cfg_context_idom(ctx, a) == -1 || cfg_context_idom(ctx, b) == -1) {
+    return -1;
+  }
+
+  while (!cfg_context_dominates(ctx, a, b)) {
+    if (cfg_context_idom(ctx, a) == a) {
+      return -1;
+    }
+    a = cfg_context_idom(ctx, a);
+  }
+
+  return a;
+}
+
+/// Fills bbs with numBBs random BBs of the CFG of ctx.
+static void fill_random_bbs(const CFGContext *ctx, int *bbs, int numBBs) {
+  int numCFGBBs = cfg_context_num_bbs(ctx);
+
+  for (int i=0 ; i<numBBs ; i++) {
+    bbs[i] = bench_random_below(numCFGBBs);
+  }
+}
+
+/// Times numQueries pair queries and numQueries / SET_SIZE set queries on
+/// the index of ctx, storing the answers to the first batch of each in
+/// pairAnswers and setAnswers.
+static void time_queries(const CFGContext *ctx, long numQueries, int *bbs,
+                         int *pairAnswers, int *setAnswers,
+                         double *pairTime, double *setTime) {
+  unsigned long long state = benchRandomState;
+
+  *pairTime = 0;
+  *setTime = 0;
+
+  // Every index answers the same queries.
+  for (long done=0 ; done<numQueries ; done+=QUERY_BATCH) {
+    int batch = numQueries - done < QUERY_BATCH
+      ? numQueries - done : QUERY_BATCH;
+
+    fill_random_bbs(ctx, bbs, 2 * batch);
+
+    double start = bench_time_s();
+    for (int i=0 ; i<batch ; i++) {
+      int answer = cfg_context_common_dominator(ctx, bbs[2*i], bbs[2*i+1]);
+
+      if (done == 0) {
+        pairAnswers[i] = answer;
+      }
+    }
+    *pairTime += bench_time_s() - start;
+
+    start = bench_time_s();
+    for (int i=0 ; i<batch/SET_SIZE ; i++) {
+      int answer = cfg_context_common_dominator_of(ctx, bbs + i * SET_SIZE,
+                                                   SET_SIZE);
+
+      if (done == 0) {
+        setAnswers[i] = answer;
+      }
+    }
+    *setTime += bench_time_s() - start;
+  }
+
+  benchRandomState = state;
+}
+
+/// Checks the answers of the first batch of queries, which are in bbs.
+/// Returns 1 if they are right.
+static int check_answers(const char *path, const CFGContext *ctx, int *bbs,
+                         int batch, const int *pairAnswers,
+                         const int *setAnswers) {
+  double start = bench_time_s();
+
+  for (int i=0 ; i<batch/SET_SIZE ; i++) {
+    int expected = bbs[i * SET_SIZE];
+
+    for (int j=1 ; j<SET_SIZE && expected != -1 ; j++) {
+      expected = cfg_context_common_dominator(ctx, expected,
+                                              bbs[i * SET_SIZE + j]);
+    }
+
+    if (setAnswers[i] != expected) {
+      fprintf(stderr, "%s: wrong common dominator of set %d\n", path, i);
+      return 0;
+    }
+  }
+
+  for (int i=0 ; i<batch ; i++) {
+    int a = bbs[2*i];
+    int b = bbs[2*i+1];
+
+    if (pairAnswers[i] != common_dominator_by_climbing(ctx, a, b)) {
+      fprintf(stderr, "%s: wrong common dominator of BBs %d and %d\n", path,
+              cfg_context_bb_id(ctx, a), cfg_context_bb_id(ctx, b));
+      return 0;
+    }
+
+    if (i % 1024 == 0 && bench_time_s() - start > CLIMB_TIME_LIMIT_S) {
+      break;
+    }
+  }
+
+  return 1;
+}
+
+/// Builds every kind of index for the CFG of ctx, times numQueries random
+/// queries on each and prints a table row per kind. Returns 1 if all the
+/// answers were right.
+static int bench_indexes(const char *path, CFGContext *ctx, long numQueries,
+                         int *bbs) {
+  int batch = numQueries < QUERY_BATCH ? numQueries : QUERY_BATCH;
+  int *pairAnswers[NUM_INDEX_KINDS];
+  int *setAnswers[NUM_INDEX_KINDS];
+  int ok = 1;
+
+  for (int k=0 ; k<NUM_INDEX_KINDS ; k++) {
+    ArenaStats before, after;
+    double pairTime, setTime;
+
+    pairAnswers[k] = malloc(batch * sizeof(int));
+    setAnswers[k] = malloc(batch * sizeof(int));
+
+    cfg_context_arena_stats(ctx, &before);
+    double start = bench_time_s();
+    cfg_context_build_lca_index(ctx, indexKinds[k].kind);
+    double buildTime = bench_time_s() - start;
+    cfg_context_arena_stats(ctx, &after);
+
+    time_queries(ctx, numQueries, bbs, pairAnswers[k], setAnswers[k],
+                 &pairTime, &setTime);
+
+    printf("%-24s %9d %-6s %9.2f %9.1f %11ld %9.2f %9.2f\n", path,
+           cfg_context_num_bbs(ctx), indexKinds[k].name, buildTime * 1e3,
+           (after.used - before.used) / 1e6, numQueries,
+           pairTime * 1e9 / numQueries,
+           setTime * 1e9 / (numQueries / SET_SIZE));
+
+    if (k > 0
+        && (memcmp(pairAnswers[k], pairAnswers[0], batch * sizeof(int)) != 0
+            || memcmp(setAnswers[k], setAnswers[0],
+                      batch / SET_SIZE * sizeof(int)) != 0)) {
+      fprintf(stderr, "%s: the %s and %s indexes disagree\n", path,
+              indexKinds[k].name, indexKinds[0].name);
+      ok = 0;
+    }
+  }
+
+  // The first batch of queries, as the indexes answered them.
+  fill_random_bbs(ctx, bbs, 2 * batch);
+  ok = ok && check_answers(path, ctx, bbs, batch, pairAnswers[0],
+                           setAnswers[0]);
+
+  for (int k=0 ; k<NUM_INDEX_KINDS ; k++) {
+    free(pairAnswers[k]);
+    free(setAnswers[k]);
+  }
+
+  return ok;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-n queries] [-P] cfg-spec...\n", prog);
+}
+
+int main(int argc, char **argv) {
+  CFGOptions opts;
+  long numQueries = 10000000;
+  int opt;
+
+  memset(&opts, 0, sizeof(opts));
+  opts.engine = DOM_ENGINE_AUTO;
+  opts.autoEngineThreshold = DEFAULT_AUTO_ENGINE_THRESHOLD;
+  opts.parser = CFG_PARSER_SIMD;
+  opts.numThreads = 1;
+
+  while ((opt = getopt(argc, argv, "n:Ph")) != -1) {
+    switch (opt) {
+    case 'n':
+      numQueries = atol(optarg);
+      break;
+    case 'P':
+      opts.postDominators = 1;
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (optind == argc || numQueries < SET_SIZE) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  int *bbs = malloc(2 * QUERY_BATCH * sizeof(int));
+  CFGContext *ctx = cfg_context_create(&opts);
+  int ok = 1;
+
+  printf("%-24s %9s %-6s %9s %9s %11s %9s %9s\n", "spec", "blocks", "index",
+         "build ms", "MB", "queries", "ns/pair", "ns/set");
+
+  for (int i=optind ; i<argc ; i++) {
+    size_t size;
+    char *spec = bench_read_file(argv[i], &size);
+
+    if (spec == NULL) {
+      return 1;
+    }
+
+    if (!cfg_context_parse(ctx, spec, size)) {
+      fprintf(stderr, "%s: not a valid CFG\n", argv[i]);
+      return 1;
+    }
+    cfg_context_analyse(ctx, NULL);
+
+    if (cfg_context_num_bbs(ctx) > 0) {
+      ok &= bench_indexes(argv[i], ctx, numQueries, bbs);
+    }
+
+    free(spec);
+  }
+
+  printf("%s\n", ok ? "ok" : "FAILED");
+  cfg_context_destroy(ctx);
+  free(bbs);
+  return ok ? 0 : 1;
+}
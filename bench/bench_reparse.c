@@ -0,0 +1,157 @@
+// Parses and analyses the same CFG specs over and over, both in one
+// CFGContext and in a new context each time, and checks that memory stays
+// flat: once every spec was parsed, the arena must not grow any more and
+// the resident set size must not creep up. Specs with loops are the ones
+// that matter, as tearing down their graphs used to recurse forever.
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/cfg.h"
+#include "bench_util.h"
+
+// Rounds run before memory is measured. malloc raises its mmap threshold
+// the first time a large block is freed, so later blocks come from the heap
+// instead and the resident set settles only after a few rounds.
+#define WARMUP_ROUNDS 5
+
+// How much the resident set may grow after the warm-up, to leave room for
+// the C library's own bookkeeping.
+#define RSS_SLACK_KB 1024
+
+typedef struct Spec {
+  const char *path;
+  char *data;
+  size_t size;
+} Spec;
+
+static long resident_kb() {
+  long pages = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+
+  if (statm != NULL) {
+    if (fscanf(statm, "%*s %ld", &pages) != 1) {
+      pages = 0;
+    }
+    fclose(statm);
+  }
+
+  return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/// Parses and analyses all the specs numRounds times, in ctx if it is not
+/// NULL and in a new context for every spec otherwise. Returns 1 if memory
+/// stayed flat after the warm-up rounds.
+static int bench_rounds(const char *name, CFGContext *ctx,
+                        const CFGOptions *opts, Spec *specs, int numSpecs,
+                        int numRounds, FILE *out) {
+  ArenaStats first, last;
+  long firstRSS = 0;
+  double start = 0;
+
+  memset(&first, 0, sizeof(first));
+  memset(&last, 0, sizeof(last));
+
+  for (int r=0 ; r<numRounds ; r++) {
+    for (int i=0 ; i<numSpecs ; i++) {
+      CFGContext *specCtx = ctx != NULL ? ctx : cfg_context_create(opts);
+
+      if (!cfg_context_parse(specCtx, specs[i].data, specs[i].size)) {
+        fprintf(stderr, "%s: not a valid CFG\n", specs[i].path);
+        return 0;
+      }
+      cfg_context_analyse(specCtx, out);
+
+      if (ctx == NULL) {
+        cfg_context_destroy(specCtx);
+      }
+    }
+
+    if (r == WARMUP_ROUNDS - 1) {
+      if (ctx != NULL) {
+        cfg_context_arena_stats(ctx, &first);
+      }
+      firstRSS = resident_kb();
+      start = bench_time_s();
+    }
+  }
+
+  double time = bench_time_s() - start;
+  long lastRSS = resident_kb();
+  if (ctx != NULL) {
+    cfg_context_arena_stats(ctx, &last);
+  }
+
+  int ok = last.reserved == first.reserved
+    && last.numBlocks == first.numBlocks
+    && lastRSS - firstRSS <= RSS_SLACK_KB;
+
+  printf("%-8s %8d %12.3f %10zu %10ld %10ld  %s\n", name, numRounds,
+         time * 1e3 / (numRounds - WARMUP_ROUNDS), last.reserved,
+         firstRSS, lastRSS, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-n rounds] cfg-spec...\n", prog);
+}
+
+int main(int argc, char **argv) {
+  CFGOptions opts;
+  int numRounds = 1000;
+  int opt;
+
+  memset(&opts, 0, sizeof(opts));
+  opts.engine = DOM_ENGINE_AUTO;
+  opts.autoEngineThreshold = DEFAULT_AUTO_ENGINE_THRESHOLD;
+  opts.parser = CFG_PARSER_SIMD;
+  opts.numThreads = 1;
+
+  while ((opt = getopt(argc, argv, "n:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      numRounds = atoi(optarg);
+      break;
+    default:
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  int numSpecs = argc - optind;
+  Spec *specs = calloc(numSpecs, sizeof(Spec));
+
+  if (numSpecs == 0 || numRounds <= WARMUP_ROUNDS) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  for (int i=0 ; i<numSpecs ; i++) {
+    specs[i].path = argv[optind + i];
+    specs[i].data = bench_read_file(specs[i].path, &specs[i].size);
+    if (specs[i].data == NULL) {
+      return 1;
+    }
+  }
+
+  FILE *out = fopen("/dev/null", "w");
+  CFGContext *ctx = cfg_context_create(&opts);
+
+  printf("%-8s %8s %12s %10s %10s %10s\n", "context", "rounds", "ms/round",
+         "arena", "rss KB", "then KB");
+
+  int ok = bench_rounds("reused", ctx, &opts, specs, numSpecs, numRounds,
+                        out)
+    & bench_rounds("new", NULL, &opts, specs, numSpecs, numRounds, out);
+
+  cfg_context_destroy(ctx);
+  fclose(out);
+
+  for (int i=0 ; i<numSpecs ; i++) {
+    free(specs[i].data);
+  }
+  free(specs);
+
+  return ok ? 0 : 1;
+}
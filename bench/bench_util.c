@@ -0,0 +1,68 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "bench_util.h"
+
+unsigned long long benchRandomState = 88172645463325252ull;
+
+double bench_time_s() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+unsigned long long bench_random() {
+  benchRandomState ^= benchRandomState << 13;
+  benchRandomState ^= benchRandomState >> 7;
+  benchRandomState ^= benchRandomState << 17;
+  return benchRandomState;
+}
+
+unsigned bench_random_below(unsigned bound) {
+  return (unsigned)((bench_random() >> 32) * bound >> 32);
+}
+
+char *bench_read_file(const char *path, size_t *size) {
+  FILE *in = fopen(path, "rb");
+  size_t capacity = 1 << 16;
+  char *data;
+
+  if (in == NULL) {
+    perror(path);
+    return NULL;
+  }
+
+  data = malloc(capacity);
+  *size = 0;
+
+  while (data != NULL) {
+    size_t numRead = fread(data + *size, 1, capacity - *size, in);
+
+    if (numRead == 0) {
+      break;
+    }
+
+    *size += numRead;
+    if (*size == capacity) {
+      char *grown = realloc(data, 2 * capacity);
+
+      if (grown == NULL) {
+        free(data);
+      }
+      data = grown;
+      capacity *= 2;
+    }
+  }
+
+  if (data == NULL) {
+    fprintf(stderr, "%s: out of memory\n", path);
+  } else if (ferror(in)) {
+    perror(path);
+    free(data);
+    data = NULL;
+  }
+
+  fclose(in);
+  return data;
+}
@@ -0,0 +1,28 @@
+#ifndef IBN_KHALDUN_BENCH_UTIL_H
+#define IBN_KHALDUN_BENCH_UTIL_H
+
+#include <stddef.h>
+
+// Helpers shared by the benchmark programs in this directory.
+
+// The state of bench_random_below. Benchmarks that replay the same random
+// sequence save it and restore it.
+extern unsigned long long benchRandomState;
+
+/// Returns the time of a monotonic clock in seconds.
+double bench_time_s();
+
+/// Returns the next 64 pseudo-random bits of an xorshift64 generator,
+/// which always starts from the same state so that every run answers the
+/// same queries.
+unsigned long long bench_random();
+
+/// Returns a pseudo-random number in [0, bound) from bench_random.
+unsigned bench_random_below(unsigned bound);
+
+/// Reads the whole file at path into a heap buffer, to be released with
+/// free, and stores its size in size. Returns NULL after printing the
+/// reason to stderr if the file cannot be read or memory runs out.
+char *bench_read_file(const char *path, size_t *size);
+
+#endif
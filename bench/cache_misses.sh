@@ -0,0 +1,24 @@
+#!/bin/sh
+# Reports the cache misses counted by perf events during parsing and
+# analysis for every dominance engine. Run it against builds of two
+# revisions to compare their memory layouts.
+#
+# Usage: bench/cache_misses.sh <build-dir> [blocks]
+set -e
+
+BUILD=${1:-build}
+N=${2:-50000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$BUILD/gen-cfg" -n $N -k random > "$TMP/cfg"
+
+printf "%-12s %14s %14s\n" engine parse analysis
+for engine in chk lt lt-balanced semi-nca; do
+  "$BUILD/ibn-khaldun" -s -e $engine < "$TMP/cfg" 2> "$TMP/stats" > /dev/null
+  awk -v engine=$engine '
+    /^cache misses: n\/a/ { printf "%-12s %14s %14s\n", engine, "n/a", "n/a" }
+    /^cache misses: parse/ {
+      sub(",", "", $4); printf "%-12s %14s %14s\n", engine, $4, $6
+    }' "$TMP/stats"
+done
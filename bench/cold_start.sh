@@ -0,0 +1,39 @@
+#!/bin/sh
+# Compares the time to get a large CFG into memory from its text spec and
+# from the same CFG converted to the binary format. The CFGs are converted
+# to /dev/null so that only loading is timed, not the analysis. Page caches
+# are dropped before each run when /proc/sys/vm/drop_caches is writable
+# (i.e. as root), otherwise the files are read from a warm cache.
+#
+# Usage: bench/cold_start.sh <build-dir> [blocks]
+set -e
+
+BUILD=${1:-build}
+N=${2:-10000000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$BUILD/gen-cfg" -n $N -k tree -r > "$TMP/cfg"
+"$BUILD/ibn-khaldun" -c "$TMP/cfg.bin" "$TMP/cfg"
+
+drop_caches() {
+  sync
+  if [ -w /proc/sys/vm/drop_caches ]; then
+    echo 3 > /proc/sys/vm/drop_caches
+    CACHE=cold
+  else
+    CACHE=warm
+  fi
+}
+
+printf "%-8s %12s %12s %12s %6s\n" format bytes edges load-ms cache
+for input in cfg cfg.bin; do
+  drop_caches
+  "$BUILD/ibn-khaldun" -s -c /dev/null "$TMP/$input" 2> "$TMP/stats"
+  awk -v format=${input#cfg.} -v cache=$CACHE '
+    /^parse:/ { ms = $2; edges = $6 }
+    /^input:/ {
+      printf "%-8s %12s %12s %12s %6s\n",
+             (format == "cfg" ? "text" : "binary"), $2, edges, ms, cache
+    }' "$TMP/stats"
+done
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Times random dominance queries on CFGs of every shape produced by gen-cfg,
+# answered from the preorder intervals of the dominator tree and, for as
+# many as fit in a few seconds, by walking up the IDOMs. The queries are
+# run on the dominator trees of the CFGs and on their post-dominator
+# forests.
+#
+# Usage: bench/dominates_queries.sh <build-dir> [blocks] [queries]
+set -e
+
+BUILD=$(cd "${1:-build}" && pwd)
+N=${2:-1000000}
+QUERIES=${3:-100000000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+for shape in tree ladder random; do
+  "$BUILD/gen-cfg" -n $N -k $shape -r > "$TMP/$shape"
+done
+
+cd "$TMP"
+"$BUILD/bench-dominates" -n $QUERIES tree ladder random
+"$BUILD/bench-dominates" -P -n $QUERIES tree ladder random
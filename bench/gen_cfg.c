@@ -0,0 +1,221 @@
+// Generates synthetic CFG specs in the grammar described in test/test1.cfg.
+// Used to produce inputs for the benchmark scripts in this directory.
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum Shape {
+  // Binary tree: block i branches to 2i+1 and 2i+2. Dominator depth is
+  // logarithmic in the number of blocks.
+  SHAPE_TREE,
+  // A chain of diamonds where every 4th diamond closes a loop back to its
+  // header, ending in an exit block. Dominator depth is linear in the
+  // number of blocks.
+  SHAPE_LADDER,
+  // Every block is reachable from a recent predecessor plus a random extra
+  // forward or backward edge.
+  SHAPE_RANDOM,
+} Shape;
+
+static unsigned long long rngState = 88172645463325252ull;
+
+static unsigned long long next_random() {
+  // xorshift64
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return rngState;
+}
+
+// Maps block numbers to the IDs printed in the spec. With sparse IDs, the
+// block number is multiplied by an odd constant modulo 2^31 which is a
+// bijection on [0, 2^31) and scatters the IDs over the whole int range.
+static int sparseIDs = 0;
+
+static int bb_id(int block) {
+  if (!sparseIDs) {
+    return block;
+  }
+
+  return (int)(((unsigned long long)block * 2654435761ull) & 0x7fffffff);
+}
+
+static void print_block(int block, const int *succs, int numSuccs) {
+  printf("%d:", bb_id(block));
+  for (int i=0 ; i<numSuccs ; i++) {
+    printf(i == 0 ? "%d" : ",%d", bb_id(succs[i]));
+  }
+  printf("\n");
+}
+
+static void gen_tree(int n) {
+  for (int i=0 ; i<n ; i++) {
+    int succs[2];
+    int numSuccs = 0;
+
+    if (2*i+1 < n) {
+      succs[numSuccs++] = 2*i+1;
+    }
+    if (2*i+2 < n) {
+      succs[numSuccs++] = 2*i+2;
+    }
+    print_block(i, succs, numSuccs);
+  }
+}
+
+static void gen_ladder(int n) {
+  // Each diamond uses blocks h, h+1, h+2, h+3 where h is the header and
+  // h+3 the join block. The join falls through to the next header.
+  for (int h=0 ; h<n ; h+=4) {
+    int succs[2];
+    int numSuccs = 0;
+    int last = h + 3 >= n;
+
+    if (last) {
+      for (int i=h ; i<n ; i++) {
+        numSuccs = 0;
+        if (i+1 < n) {
+          succs[numSuccs++] = i+1;
+        }
+        print_block(i, succs, numSuccs);
+      }
+      break;
+    }
+
+    succs[0] = h+1;
+    succs[1] = h+2;
+    print_block(h, succs, 2);
+    succs[0] = h+3;
+    print_block(h+1, succs, 1);
+    print_block(h+2, succs, 1);
+
+    // Every 4th join block loops back to the header of its diamond, except
+    // for the last block, which exits the CFG so that its post-dominators
+    // are defined.
+    if (h+4 < n) {
+      succs[numSuccs++] = h+4;
+      if ((h/4) % 4 == 3) {
+        succs[numSuccs++] = h;
+      }
+    }
+    print_block(h+3, succs, numSuccs);
+  }
+}
+
+static void gen_random(int n) {
+  // Pick for every block a parent among the few blocks created just before
+  // it so the graph stays connected without giving any block too many
+  // successors.
+  int *numSuccs = calloc(n, sizeof(int));
+  int (*succs)[3] = malloc(n * sizeof(*succs));
+
+  for (int i=1 ; i<n ; i++) {
+    int window = i < 4 ? i : 4;
+    int parent;
+
+    do {
+      parent = i - 1 - (int)(next_random() % window);
+    } while (numSuccs[parent] >= 2 && parent != i - 1);
+
+    succs[parent][numSuccs[parent]++] = i;
+  }
+
+  for (int i=0 ; i<n ; i++) {
+    if (numSuccs[i] < 3 && next_random() % 4 == 0) {
+      int target = (int)(next_random() % n);
+      if (target != 0) {
+        succs[i][numSuccs[i]++] = target;
+      }
+    }
+    print_block(i, succs[i], numSuccs[i]);
+  }
+
+  free(numSuccs);
+  free(succs);
+}
+
+static void gen_cfg(Shape shape, int n) {
+  switch (shape) {
+  case SHAPE_TREE:
+    gen_tree(n);
+    break;
+  case SHAPE_LADDER:
+    gen_ladder(n);
+    break;
+  case SHAPE_RANDOM:
+    gen_random(n);
+    break;
+  }
+}
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-n blocks] [-k tree|ladder|random] [-r] "
+          "[-f functions] [-S seed]\n", prog);
+  fprintf(stderr, "  -r  use sparse, scattered BB IDs\n");
+  fprintf(stderr, "  -f  generate this many CFGs, each starting with a "
+          "delimiter line. Like in\n      real programs most are small: "
+          "each has n/2^k blocks for a random k\n      in [0, 10]\n");
+}
+
+int main(int argc, char **argv) {
+  int n = 1000;
+  int numFunctions = 0;
+  Shape shape = SHAPE_TREE;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:k:rf:S:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      n = atoi(optarg);
+      break;
+    case 'k':
+      if (strcmp(optarg, "tree") == 0) {
+        shape = SHAPE_TREE;
+      } else if (strcmp(optarg, "ladder") == 0) {
+        shape = SHAPE_LADDER;
+      } else if (strcmp(optarg, "random") == 0) {
+        shape = SHAPE_RANDOM;
+      } else {
+        print_usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'r':
+      sparseIDs = 1;
+      break;
+    case 'f':
+      numFunctions = atoi(optarg);
+      break;
+    case 'S':
+      rngState = strtoull(optarg, NULL, 10) | 1;
+      break;
+    default:
+      print_usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (n <= 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  if (numFunctions == 0) {
+    printf("! Generated by gen-cfg: %d blocks\n", n);
+    gen_cfg(shape, n);
+    return 0;
+  }
+
+  printf("! Generated by gen-cfg: %d functions of up to %d blocks\n",
+         numFunctions, n);
+
+  for (int i=0 ; i<numFunctions ; i++) {
+    int size = n >> (next_random() % 11);
+
+    printf("@f%d\n", i);
+    gen_cfg(shape, size > 0 ? size : 1);
+  }
+
+  return 0;
+}
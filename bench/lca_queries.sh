@@ -0,0 +1,21 @@
+#!/bin/sh
+# Times nearest common dominator queries with each kind of LCA index on
+# CFGs of every shape produced by gen-cfg, and checks their answers, for
+# both the dominator trees and the post-dominator forests of the CFGs.
+#
+# Usage: bench/lca_queries.sh <build-dir> [blocks] [queries]
+set -e
+
+BUILD=$(cd "${1:-build}" && pwd)
+N=${2:-1000000}
+QUERIES=${3:-10000000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+for shape in tree ladder random; do
+  "$BUILD/gen-cfg" -n $N -k $shape -r > "$TMP/$shape"
+done
+
+cd "$TMP"
+"$BUILD/bench-lca" -n $QUERIES tree ladder random
+"$BUILD/bench-lca" -P -n $QUERIES tree ladder random
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Measures how the time spent loading a CFG scales with its number of
+# blocks. The last column is the per-block cost relative to the smallest
+# CFG. Looking BB IDs up by scanning the pool made it grow with the number
+# of blocks, 16x from the first row to the last. With the hashed index it
+# grows only as the index and pool outgrow the caches, to 2-2.5x at 400k
+# blocks.
+#
+# Usage: bench/load_scaling.sh <build-dir>
+set -e
+
+BUILD=${1:-build}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+printf "%10s %12s %12s %8s\n" blocks parse-ms ns/block growth
+for n in 25000 50000 100000 200000 400000; do
+  "$BUILD/gen-cfg" -n $n -k tree -r > "$TMP/cfg"
+  "$BUILD/ibn-khaldun" -s < "$TMP/cfg" 2> "$TMP/stats" > /dev/null
+  awk -v n=$n '/^parse:/ { print n, $2, $8 }' "$TMP/stats"
+done | awk '
+  NR == 1 { first = $3 }
+  { printf "%10d %12s %12s %7.1fx\n", $1, $2, $3, $3 / first }'
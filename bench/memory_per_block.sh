@@ -0,0 +1,20 @@
+#!/bin/sh
+# Reports how many bytes the parsed graph takes per block for each of the
+# shapes produced by gen-cfg.
+#
+# Usage: bench/memory_per_block.sh <build-dir> [blocks]
+set -e
+
+BUILD=${1:-build}
+N=${2:-50000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+printf "%-8s %10s %12s %12s\n" shape blocks bytes bytes/block
+for shape in tree ladder random; do
+  "$BUILD/gen-cfg" -n $N -k $shape > "$TMP/cfg"
+  "$BUILD/ibn-khaldun" -s -e semi-nca < "$TMP/cfg" 2> "$TMP/stats" > /dev/null
+  awk -v shape=$shape -v n=$N \
+    '/^graph:/ { printf "%-8s %10d %12s %12s\n", shape, n, $2, $4 }' \
+    "$TMP/stats"
+done
@@ -0,0 +1,342 @@
+#!/bin/sh
+# Differential check of the input parsers: every parser must build the same
+# CFG (and so print the same dominance information) as the strtok parser on
+# generated CFG specs, and the simd parser must agree with the scan parser
+# on specs that exercise the corners of the grammar which the strtok parser
+# does not support (long lines, comments after IDs, missing final newline).
+# Parsing with several threads must give the same result as with one, and
+# analysing a multi-CFG spec in one batch the same as analysing each of its
+# CFGs on its own, with any number of worker threads. The dominator sets
+# rebuilt from the idom output format must be the ones of the full format,
+# and the json, binary and dot formats must hold the same BBs, edges, idoms
+# and depths as the text formats. Post-dominators must be the same with
+# every engine, and the dominators of the spec with its edges reversed by
+# hand.
+#
+# Usage: bench/parse_diff.sh <build-dir> [blocks]
+set -e
+
+BUILD=${1:-build}
+N=${2:-3000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+FAILED=0
+
+check() {
+  reference=$1
+  shift
+  "$BUILD/ibn-khaldun" -e semi-nca -p $reference "$TMP/cfg" > "$TMP/expected"
+  for parser in "$@"; do
+    "$BUILD/ibn-khaldun" -e semi-nca $parser "$TMP/cfg" > "$TMP/actual"
+    if cmp -s "$TMP/expected" "$TMP/actual"; then
+      echo "ok      $parser vs $reference: $name"
+    else
+      echo "FAILED  $parser vs $reference: $name"
+      FAILED=1
+    fi
+  done
+}
+
+for kind in tree ladder random; do
+  for ids in "" -r; do
+    name="gen-cfg -n $N -k $kind $ids"
+    "$BUILD/gen-cfg" -n $N -k $kind $ids > "$TMP/cfg"
+    check strtok "-p scan" "-p simd"
+  done
+done
+
+for kind in tree random; do
+  name="gen-cfg -n $((N * 100)) -k $kind -r"
+  "$BUILD/gen-cfg" -n $((N * 100)) -k $kind -r > "$TMP/cfg"
+  check simd "-p simd -j 4" "-p scan -j 7"
+done
+
+for seed in 1 2 3 4 5 6 7 8; do
+  name="mangled spec, seed $seed"
+  # Lines of random length whose IDs straddle block boundaries, padded with
+  # mixed separators, with long and negative IDs and trailing comments.
+  awk -v seed=$seed -v n=$N 'BEGIN {
+    srand(seed)
+    for (i=0 ; i<n ; i++) {
+      line = i ":"
+      for (j=int(rand() * 12) ; j>0 ; j--) {
+        pad = ""
+        for (k=int(rand() * 70) ; k>=0 ; k--) {
+          pad = pad substr(" \t,:", int(rand() * 4) + 1, 1)
+        }
+        r = rand()
+        if (r < 0.05) {
+          id = "-" int(rand() * n)
+        } else if (r < 0.1) {
+          id = sprintf("%d%09d", int(rand() * 10^8), int(rand() * 10^9))
+        } else if (r < 0.12) {
+          id = "00000000000" int(rand() * n)
+        } else if (r < 0.13) {
+          id = int(rand() * n) "-" int(rand() * n)
+        } else {
+          id = int(rand() * n)
+        }
+        line = line pad id
+      }
+      if (rand() < 0.1) {
+        line = line " ! 1, 2, 3 " sprintf("%80s", "")
+      }
+      printf "%s%s", line, (i < n - 1 ? "\n" : "")
+    }
+  }' > "$TMP/cfg"
+  check scan "-p simd"
+done
+
+name="gen-cfg -f 200 -n 500 -k random -r"
+"$BUILD/gen-cfg" -f 200 -n 500 -k random -r > "$TMP/cfg"
+"$BUILD/ibn-khaldun" -e semi-nca "$TMP/cfg" > "$TMP/actual"
+awk -v dir="$TMP" '/^@/ { file = dir "/f" ++n } file { print > file }' \
+  "$TMP/cfg"
+for i in $(seq 1 200); do
+  head -n 1 "$TMP/f$i"
+  tail -n +2 "$TMP/f$i" | "$BUILD/ibn-khaldun" -e semi-nca -p strtok
+done > "$TMP/expected"
+if cmp -s "$TMP/expected" "$TMP/actual"; then
+  echo "ok      batch vs one by one: $name"
+else
+  echo "FAILED  batch vs one by one: $name"
+  FAILED=1
+fi
+
+for j in 4 7; do
+  "$BUILD/ibn-khaldun" -e semi-nca -j $j "$TMP/cfg" > "$TMP/threaded"
+  if cmp -s "$TMP/actual" "$TMP/threaded"; then
+    echo "ok      batch -j $j vs -j 1: $name"
+  else
+    echo "FAILED  batch -j $j vs -j 1: $name"
+    FAILED=1
+  fi
+done
+
+for kind in tree ladder random; do
+  name="gen-cfg -n $N -k $kind -r"
+  "$BUILD/gen-cfg" -n $N -k $kind -r > "$TMP/cfg"
+  "$BUILD/ibn-khaldun" -e semi-nca "$TMP/cfg" \
+    | grep -E '^(BBID|# Doms):' > "$TMP/expected"
+  # Walk up the IDOMs of each BB to the entry, which is its own IDOM, and
+  # check its depth on the way.
+  "$BUILD/ibn-khaldun" -e semi-nca -f idom -d "$TMP/cfg" | awk '
+    { idom[$1] = $2; depth[$1] = $3; order[NR] = $1 }
+    END {
+      for (i=1 ; i<=NR ; i++) {
+        n = 0
+        for (d=order[i] ; ; d=idom[d]) {
+          chain[n++] = d
+          if (idom[d] == d) {
+            break
+          }
+        }
+        printf "BBID: %s\n# Doms: %d [", order[i], n
+        for (k=n-1 ; k>=0 ; k--) {
+          printf "%s%s", chain[k], (k > 0 ? ", " : "")
+        }
+        printf "]\n"
+        if (depth[order[i]] != n - 1) {
+          print "bad depth of " order[i]
+        }
+      }
+    }' > "$TMP/actual"
+  if cmp -s "$TMP/expected" "$TMP/actual"; then
+    echo "ok      -f idom -d vs -f full: $name"
+  else
+    echo "FAILED  -f idom -d vs -f full: $name"
+    FAILED=1
+  fi
+done
+
+# Prints a binary result record (from stdin) as the idom format with
+# depths, or "bad flags" if its flags are not $1. The record is a header of
+# 7 ints followed by the ids, idoms, depths and rpo arrays (an unnamed CFG
+# has no name).
+binary_to_idom() {
+  od -An -v -t d4 | awk -v flags=$1 '
+    { for (i=1 ; i<=NF ; i++) { v[n++] = $i } }
+    END {
+      if (v[3] != flags) {
+        print "bad flags"
+      }
+      bbs = v[4]
+      reachable = v[5]
+      for (i=0 ; i<reachable ; i++) {
+        bb = v[7 + 3 * bbs + i]
+        print v[7 + bb], v[7 + v[7 + bbs + bb]], v[7 + 2 * bbs + bb]
+      }
+    }'
+}
+
+compare() {
+  if cmp -s "$TMP/expected" "$TMP/actual"; then
+    echo "ok      $1: $name"
+  else
+    echo "FAILED  $1: $name"
+    FAILED=1
+  fi
+}
+
+for kind in tree ladder random; do
+  name="gen-cfg -n $N -k $kind -r"
+  "$BUILD/gen-cfg" -n $N -k $kind -r > "$TMP/cfg"
+  "$BUILD/ibn-khaldun" -e semi-nca -f idom -d "$TMP/cfg" > "$TMP/idom"
+  "$BUILD/ibn-khaldun" -e semi-nca "$TMP/cfg" \
+    | grep -E '^(BBID|# Preds|# Succs):' > "$TMP/full"
+
+  # Split each object at its punctuation: key names switch the list the
+  # numbers that follow them go to.
+  "$BUILD/ibn-khaldun" -e semi-nca -f json "$TMP/cfg" | awk -v dir="$TMP" '
+    function list(label, key) {
+      printf "# %s: %d [", label, count[key] > dir "/json_full"
+      for (i=0 ; i<count[key] ; i++) {
+        printf "%s%s", (i > 0 ? ", " : ""), value[key, i] > dir "/json_full"
+      }
+      printf "]\n" > dir "/json_full"
+    }
+    {
+      n = split($0, tokens, /[][{}:,"]+/)
+      delete count
+      for (t=1 ; t<=n ; t++) {
+        if (tokens[t] ~ /^[a-z]+$/) {
+          key = tokens[t]
+        } else if (tokens[t] != "") {
+          value[key, count[key]++] = tokens[t]
+        }
+      }
+      print value["id", 0], value["idom", 0], value["depth", 0] \
+        > dir "/json_idom"
+      print "BBID: " value["id", 0] > dir "/json_full"
+      list("Preds", "preds")
+      list("Succs", "succs")
+    }'
+  cp "$TMP/full" "$TMP/expected"
+  cp "$TMP/json_full" "$TMP/actual"
+  compare "-f json vs -f full"
+  cp "$TMP/idom" "$TMP/expected"
+  cp "$TMP/json_idom" "$TMP/actual"
+  compare "-f json vs -f idom -d"
+
+  "$BUILD/ibn-khaldun" -e semi-nca -f binary "$TMP/cfg" \
+    | binary_to_idom 0 > "$TMP/actual"
+  compare "-f binary vs -f idom -d"
+
+  # Edges of the CFG and of the dominator tree, one "from -> to" per line.
+  awk '/^BBID:/ { bb = $2 }
+       /^# Succs:/ {
+         gsub(/[][,]/, "")
+         for (i=4 ; i<=NF ; i++) {
+           print bb " -> " $i
+         }
+       }' "$TMP/full" | sort > "$TMP/cfg_edges"
+  awk '$1 != $2 { print $2 " -> " $1 }' "$TMP/idom" | sort > "$TMP/dom_edges"
+  for format in dot-cfg dot-domtree dot; do
+    case $format in
+      dot-cfg) cp "$TMP/cfg_edges" "$TMP/expected" ;;
+      dot-domtree) cp "$TMP/dom_edges" "$TMP/expected" ;;
+      dot) sort "$TMP/cfg_edges" "$TMP/dom_edges" > "$TMP/expected" ;;
+    esac
+    "$BUILD/ibn-khaldun" -e semi-nca -f $format "$TMP/cfg" \
+      | sed -n 's/^  \(.* -> [^ ;]*\).*/\1/p' | sort > "$TMP/actual"
+    compare "-f $format vs -f full"
+  done
+done
+
+for kind in tree ladder random; do
+  name="gen-cfg -n $N -k $kind -r"
+  "$BUILD/gen-cfg" -n $N -k $kind -r > "$TMP/cfg"
+  "$BUILD/ibn-khaldun" -e semi-nca -P -f idom -d "$TMP/cfg" > "$TMP/expected"
+  for engine in iterative chk lt lt-balanced; do
+    "$BUILD/ibn-khaldun" -e $engine -P -f idom -d "$TMP/cfg" > "$TMP/actual"
+    compare "-P -e $engine vs -e semi-nca"
+  done
+
+  # The reversed spec starts with a new BB whose succs are the exits. It
+  # comes first in reverse-post-order, and the BBs it is the IDOM of are
+  # their own IPDOMs, one level up.
+  awk -F: '
+    /^!/ { next }
+    {
+      bb[++n] = $1
+      used[$1] = 1
+      m = split($2, succs, ",")
+      if (m == 0) {
+        exits = exits (exits == "" ? "" : ",") $1
+      }
+      for (i=1 ; i<=m ; i++) {
+        if (succs[i] in preds) {
+          preds[succs[i]] = preds[succs[i]] "," $1
+        } else {
+          preds[succs[i]] = $1
+        }
+      }
+    }
+    END {
+      for (id=1 ; id in used ; id++) {
+      }
+      print id ":" exits
+      for (i=1 ; i<=n ; i++) {
+        print bb[i] ":" preds[bb[i]]
+      }
+    }' "$TMP/cfg" > "$TMP/reversed"
+  "$BUILD/ibn-khaldun" -e semi-nca -f idom -d "$TMP/reversed" \
+    | awk 'NR == 1 { exit_id = $1; next }
+           { print $1, ($2 == exit_id ? $1 : $2), $3 - 1 }' \
+    | sort > "$TMP/expected"
+  "$BUILD/ibn-khaldun" -e semi-nca -P -f idom -d "$TMP/cfg" | sort \
+    > "$TMP/actual"
+  compare "-P vs reversed spec"
+
+  "$BUILD/ibn-khaldun" -e semi-nca -P -f idom -d "$TMP/cfg" > "$TMP/expected"
+  "$BUILD/ibn-khaldun" -e semi-nca -P -f binary "$TMP/cfg" \
+    | binary_to_idom 1 > "$TMP/actual"
+  compare "-P -f binary vs -P -f idom -d"
+done
+
+name="gen-cfg -n $N -k random -r, with unreachable BBs"
+# Every tenth BB gets a new pred, unreachable from the entry, and every
+# other new BB a pred among the new ones.
+"$BUILD/gen-cfg" -n $N -k random -r | awk -F: '
+  !/^!/ {
+    used[$1] = 1
+    bb[++n] = $1
+    print
+  }
+  END {
+    id = 1
+    for (i=10 ; i<=n ; i+=10) {
+      while (id in used) {
+        id++
+      }
+      used[id] = 1
+      print id ":" bb[i] (i % 20 == 0 ? "," prev : "")
+      prev = id
+    }
+  }' > "$TMP/cfg"
+# Every BB, as "id idom" with an idom of -1 if the BB is unreachable.
+"$BUILD/ibn-khaldun" -e semi-nca -f json "$TMP/cfg" \
+  | sed 's/^{"id":\([^,]*\),.*"idom":\([^,]*\),.*/\1 \2/; s/null/-1/' \
+  | sort > "$TMP/actual"
+"$BUILD/ibn-khaldun" -e semi-nca -f binary "$TMP/cfg" \
+  | od -An -v -t d4 | awk '
+    { for (i=1 ; i<=NF ; i++) { v[n++] = $i } }
+    END {
+      bbs = v[4]
+      for (bb=0 ; bb<bbs ; bb++) {
+        idom = v[7 + bbs + bb]
+        print v[7 + bb], (idom == -1 ? -1 : v[7 + idom])
+      }
+    }' | sort > "$TMP/expected"
+compare "-f json vs -f binary"
+
+name="gen-cfg -f 200 -n 500 -k random -r"
+"$BUILD/gen-cfg" -f 200 -n 500 -k random -r > "$TMP/cfg"
+for format in json binary; do
+  "$BUILD/ibn-khaldun" -e semi-nca -f $format "$TMP/cfg" > "$TMP/expected"
+  "$BUILD/ibn-khaldun" -e semi-nca -f $format -j 4 "$TMP/cfg" \
+    > "$TMP/actual"
+  compare "batch -f $format -j 4 vs -j 1"
+done
+
+exit $FAILED
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Measures how parsing scales with the number of parser threads (-j) on a
+# generated CFG spec with sparse BBIDs. Speedups are relative to 1 thread
+# and are bounded by the number of cores and by the sequential merge of
+# the per-thread tables.
+#
+# Usage: bench/parse_scaling.sh <build-dir> [blocks]
+set -e
+
+BUILD=${1:-build}
+N=${2:-4000000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$BUILD/gen-cfg" -n $N -k random -r > "$TMP/cfg"
+
+echo "cores: $(nproc)"
+printf "%-8s %12s %12s %10s\n" threads parse-ms MB/s speedup
+for threads in 1 4 16 64; do
+  "$BUILD/ibn-khaldun" -s -e semi-nca -j $threads "$TMP/cfg" \
+    2> "$TMP/stats" > /dev/null
+  awk -v threads=$threads -v base="$BASE" '
+    /^parse:/ { ms = $2 }
+    /^input:/ {
+      printf "%-8s %12s %12s %9.2fx\n", threads, ms, $4,
+             (base != "" ? base : ms) / ms
+    }' "$TMP/stats"
+  if [ -z "$BASE" ]; then
+    BASE=$(awk '/^parse:/ { print $2 }' "$TMP/stats")
+  fi
+done
@@ -0,0 +1,21 @@
+#!/bin/sh
+# Compares the throughput of the input parsers on a generated CFG spec.
+#
+# Usage: bench/parse_throughput.sh <build-dir> [blocks]
+set -e
+
+BUILD=${1:-build}
+N=${2:-2000000}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$BUILD/gen-cfg" -n $N -k tree > "$TMP/cfg"
+
+printf "%-8s %12s %12s\n" parser parse-ms MB/s
+for parser in strtok scan simd; do
+  "$BUILD/ibn-khaldun" -s -e semi-nca -p $parser "$TMP/cfg" \
+    2> "$TMP/stats" > /dev/null
+  awk -v parser=$parser '
+    /^parse:/ { ms = $2 }
+    /^input:/ { printf "%-8s %12s %12s\n", parser, ms, $4 }' "$TMP/stats"
+done
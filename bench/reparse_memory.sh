@@ -0,0 +1,19 @@
+#!/bin/sh
+# Parses and analyses CFGs with loops (the spec of test/test1.cfg and
+# generated ones) over and over, reusing one analysis context and with a
+# new context every time, and fails if memory grows from one round to the
+# next.
+#
+# Usage: bench/reparse_memory.sh <build-dir> [rounds]
+set -e
+
+BUILD=${1:-build}
+ROUNDS=${2:-100}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+"$BUILD/gen-cfg" -n 2000 -k ladder > "$TMP/ladder"
+"$BUILD/gen-cfg" -n 20000 -k random -r > "$TMP/random"
+
+"$BUILD/bench-reparse" -n $ROUNDS "$(dirname "$0")/../test/test1.cfg" \
+  "$TMP/ladder" "$TMP/random"
@@ -0,0 +1,62 @@
+#ifndef IBN_KHALDUN_ARENA_H
+#define IBN_KHALDUN_ARENA_H
+
+#include <stddef.h>
+
+// A bump-pointer allocator for memory that lives exactly as long as one
+// CFG. Allocations are carved out of large blocks and are never freed one
+// by one: arena_reset makes all the memory of the arena available again in
+// O(1) and keeps the blocks for the next CFG, so a batch of CFGs ends up
+// being analysed in a few blocks sized for the largest of them.
+//
+// Every allocation is aligned to ARENA_ALIGNMENT bytes (a cache line). An
+// arena must only be used by one thread at a time.
+#define ARENA_ALIGNMENT        64
+#define ARENA_MIN_BLOCK_SIZE   (1 << 16)
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct Arena {
+  ArenaBlock *blocks;
+  // The block allocations are carved out of, NULL right after a reset.
+  ArenaBlock *current;
+  // Bytes used in current and in the blocks used before it since the last
+  // reset.
+  size_t currentOffset;
+  size_t usedBefore;
+  size_t highWater;
+  size_t reserved;
+  int numBlocks;
+} Arena;
+
+typedef struct ArenaStats {
+  // Bytes handed out since the last reset.
+  size_t used;
+  // The most bytes ever handed out between two resets.
+  size_t highWater;
+  // Bytes of all the blocks, including their unused tails.
+  size_t reserved;
+  int numBlocks;
+} ArenaStats;
+
+void arena_init(Arena *arena);
+
+/// Returns size bytes of uninitialized memory that stay valid until the
+/// next arena_reset or arena_release.
+void *arena_alloc(Arena *arena, size_t size);
+
+/// Resizes the allocation at p of oldSize bytes (p may be NULL if oldSize is
+/// 0) to newSize bytes and returns it. The allocation grows in place if it
+/// is the last one of the arena and its block has room. Otherwise it is
+/// copied and its old memory is only reclaimed by the next reset.
+void *arena_grow(Arena *arena, void *p, size_t oldSize, size_t newSize);
+
+/// Frees all the allocations of arena at once but keeps its blocks.
+void arena_reset(Arena *arena);
+
+/// Frees all the allocations and the blocks of arena.
+void arena_release(Arena *arena);
+
+void arena_stats(const Arena *arena, ArenaStats *stats);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef IBN_KHALDUN_BITSET_H
+#define IBN_KHALDUN_BITSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed size sets of small non-negative integers packed into 64-bit words.
+// A set is just an array of words; its size is passed to every operation so
+// that many sets of the same size can live in one contiguous allocation.
+typedef uint64_t BitsetWord;
+
+#define BITSET_WORD_BITS 64
+
+static inline size_t bitset_num_words(size_t numBits) {
+  return (numBits + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+}
+
+static inline void bitset_set(BitsetWord *set, size_t bit) {
+  set[bit / BITSET_WORD_BITS] |= (BitsetWord)1 << (bit % BITSET_WORD_BITS);
+}
+
+static inline int bitset_test(const BitsetWord *set, size_t bit) {
+  return (set[bit / BITSET_WORD_BITS] >> (bit % BITSET_WORD_BITS)) & 1;
+}
+
+// Kernels used for bitset_and and bitset_equal. The widest ones supported
+// by the CPU are selected at program startup.
+typedef enum BitsetImpl {
+  BITSET_IMPL_SCALAR,
+  BITSET_IMPL_AVX2,
+  BITSET_IMPL_AVX512,
+} BitsetImpl;
+
+/// Returns 1 if the kernels of impl can run on this CPU and 0 otherwise.
+int bitset_impl_supported(BitsetImpl impl);
+
+/// Switches to the kernels of impl. Returns 0 (and leaves the current
+/// kernels in place) if they are not supported.
+int bitset_use_impl(BitsetImpl impl);
+
+BitsetImpl bitset_current_impl(void);
+const char *bitset_impl_name(BitsetImpl impl);
+
+/// Makes set contain exactly the bits [0, numBits).
+void bitset_fill(BitsetWord *set, size_t numBits);
+
+/// dest = dest & src
+void bitset_and(BitsetWord *dest, const BitsetWord *src, size_t numWords);
+
+/// Returns 1 if a and b contain the same bits and 0 otherwise.
+int bitset_equal(const BitsetWord *a, const BitsetWord *b, size_t numWords);
+
+/// Returns the number of bits set.
+size_t bitset_count(const BitsetWord *set, size_t numWords);
+
+#endif
@@ -1,3 +1,189 @@
+#ifndef IBN_KHALDUN_CFG_H
+#define IBN_KHALDUN_CFG_H
+
 #include <stdio.h>
 
-void parse_cgf_from_file(FILE *in);
+#include "arena.h"
+
+// CFGs with fewer BBs than this are analysed by the iterative engine when
+// DOM_ENGINE_AUTO is selected. The iterative engine stores a full dominator
+// set per BB, which takes memory quadratic in the number of BBs.
+#define DEFAULT_AUTO_ENGINE_THRESHOLD 64
+
+typedef enum DominanceEngine {
+  // Picks DOM_ENGINE_ITERATIVE for CFGs smaller than
+  // CFGOptions::autoEngineThreshold and DOM_ENGINE_SEMI_NCA otherwise.
+  DOM_ENGINE_AUTO,
+  // Iterative data-flow over full dominator sets, see Section 9.2.1 of
+  // "Engineering a compiler", 2011.
+  DOM_ENGINE_ITERATIVE,
+  // Iterative computation of immediate dominators only, see "A Simple,
+  // Fast Dominance Algorithm", Cooper, Harvey and Kennedy, 2001.
+  DOM_ENGINE_CHK,
+  // Lengauer-Tarjan with the simple (path compression only) and the
+  // sophisticated (balanced linking) versions of LINK and EVAL, see "A Fast
+  // Algorithm for Finding Dominators in a Flowgraph", 1979.
+  DOM_ENGINE_LT,
+  DOM_ENGINE_LT_BALANCED,
+  // Semidominators as in Lengauer-Tarjan followed by a nearest common
+  // ancestor walk, see "Finding Dominators in Practice", 2006.
+  DOM_ENGINE_SEMI_NCA,
+} DominanceEngine;
+
+// The simd and scan parsers also accept binary CFG files (see cfg_binary.h),
+// which are recognized by their magic number and used in place.
+typedef enum CFGParser {
+  // Like CFG_PARSER_SCAN, but classifies 64 bytes of input at a time with
+  // SIMD instructions and converts whole IDs at once.
+  CFG_PARSER_SIMD,
+  // Scans the input in place (memory-mapped if it is a regular file).
+  CFG_PARSER_SCAN,
+  // The original fgets/strtok parser, kept as a reference. It reads a
+  // single text CFG and rejects '@' delimiter lines and binary CFGs.
+  CFG_PARSER_STRTOK,
+} CFGParser;
+
+// How the BBs are printed once their dominators are known.
+typedef enum CFGOutputFormat {
+  // Every BB reachable from the entry, in reverse-post-order, with its
+  // preds, succs and full dominator set. The sets make the output quadratic
+  // in the depth of the dominator tree.
+  CFG_OUTPUT_FULL,
+  // A "BBID IDOM" line per BB reachable from the entry, in
+  // reverse-post-order, followed by the BB's depth in the dominator tree
+  // (0 for the entry) if CFGOptions::printDepths is set. The entry is its
+  // own IDOM. The dominator set of a BB is its chain of IDOMs up to the
+  // entry, so nothing is lost and the output is linear in the number of BBs.
+  CFG_OUTPUT_IDOMS,
+  // A JSON object per line and BB, such as
+  //   {"id":5,"preds":[1],"succs":[8,6,7],"idom":1,"depth":2}
+  // where the entry is its own idom and has depth 0. The BBs reachable from
+  // the entry come first, in reverse-post-order, followed by the
+  // unreachable ones in the order of their first appearance, whose idom
+  // and depth are null. The delimiter line of a named CFG is printed as
+  // {"cfg":"@name"} before its BBs.
+  CFG_OUTPUT_JSON,
+  // A result record per CFG in the binary format of cfg_binary.h.
+  CFG_OUTPUT_BINARY,
+  // A GraphViz digraph per CFG, named after its delimiter line, with the
+  // CFG's edges and the dominator tree's edges (from each IDOM to the BBs
+  // it immediately dominates) overlaid as dotted lines, or with only one
+  // of the two. The entry BB is drawn as a double octagon and BBs
+  // unreachable from it with dashed lines.
+  CFG_OUTPUT_DOT,
+  CFG_OUTPUT_DOT_CFG,
+  CFG_OUTPUT_DOT_DOM_TREE,
+} CFGOutputFormat;
+
+typedef struct CFGOptions {
+  // Report the time spent in each phase of the analysis on stderr.
+  int printStats;
+  DominanceEngine engine;
+  int autoEngineThreshold;
+  CFGParser parser;
+  CFGOutputFormat outputFormat;
+  int printDepths;
+  // Compute post-dominators instead of dominators: the dominators of the
+  // reverse CFG, entered from a virtual exit whose succs are the BBs
+  // without succs. Every output format and query then reads "dominator"
+  // as "post-dominator", "IDOM" as "IPDOM" and "reachable from the entry"
+  // as "reaching an exit". The virtual exit is not printed, so the
+  // post-dominator tree is a forest whose roots are the BBs without any
+  // other post-dominator, the exits among them: each is its own IPDOM, at
+  // depth 0. Binary result records are marked with
+  // CFG_RESULT_POST_DOMINATORS.
+  int postDominators;
+  // Number of threads analysing the CFGs of a multi-CFG input, one CFG per
+  // thread at a time. With a single CFG, the threads parse it instead (with
+  // the simd and scan parsers).
+  int numThreads;
+  // If set, the parsed CFG is written to this file in the binary format of
+  // cfg_binary.h instead of being analysed.
+  FILE *binaryOutput;
+  // The file descriptor parse_cgf_from_file prints the analysis to, in
+  // writes of up to a megabyte.
+  int outputFd;
+} CFGOptions;
+
+// The state of the analysis of one CFG at a time: the graph, the arrays
+// filled by the analysis and the memory reused from one CFG to the next.
+// Contexts share no state, so any number of them can be used concurrently
+// without locks, each by one thread at a time.
+typedef struct CFGContext CFGContext;
+
+/// Creates a context analysing CFGs according to opts, which are copied.
+/// opts->binaryOutput and opts->outputFd are ignored.
+CFGContext *cfg_context_create(const CFGOptions *opts);
+
+/// Makes the CFG in the size bytes at spec the current CFG of ctx, replacing
+/// the previous one. spec is either the text spec of a single CFG (without
+/// '@' delimiter lines) or a binary CFG (see cfg_binary.h), which is used
+/// in place and must be kept until the next call or cfg_context_destroy.
+/// Returns 1 on success and 0 if spec is not a valid binary CFG or, with
+/// the strtok parser, holds a delimiter line.
+int cfg_context_parse(CFGContext *ctx, const char *spec, size_t size);
+
+/// Calculates the dominance information of the current CFG of ctx and
+/// prints its BBs to out in reverse-post-order, unless out is NULL.
+void cfg_context_analyse(CFGContext *ctx, FILE *out);
+
+// Queries on the current CFG of ctx once it is analysed. BBs are numbered
+// 0 .. cfg_context_num_bbs(ctx)-1 in the order their BBIDs first appear in
+// the spec (or as in the binary CFG), and BB 0 is the entry.
+int cfg_context_num_bbs(const CFGContext *ctx);
+int cfg_context_bb_id(const CFGContext *ctx, int bb);
+
+/// Returns the immediate dominator of bb (the entry is its own), or -1 if
+/// bb is unreachable from the entry.
+int cfg_context_idom(const CFGContext *ctx, int bb);
+
+/// Returns 1 if BB a dominates BB b and 0 otherwise, in constant time: the
+/// analysis numbers the dominator tree in preorder, and a dominates b if
+/// b's number lies in the range of a's subtree. BBs unreachable from the
+/// entry neither dominate nor are dominated by any BB, not even themselves.
+int cfg_context_dominates(const CFGContext *ctx, int a, int b);
+int cfg_context_strictly_dominates(const CFGContext *ctx, int a, int b);
+
+// Indexes of the dominator tree answering cfg_context_common_dominator
+// queries.
+typedef enum LCAIndexKind {
+  // A sparse table of range minima over the preorder of the tree: O(1)
+  // queries, n log n ints for n BBs.
+  LCA_INDEX_SPARSE_TABLE,
+  // A jump pointer per BB: O(log n) queries, n ints.
+  LCA_INDEX_JUMP_POINTERS,
+} LCAIndexKind;
+
+/// Builds an index of kind for the nearest common dominator queries below
+/// in the arena of ctx. The current CFG must be analysed, and analysing it
+/// again drops the index.
+void cfg_context_build_lca_index(CFGContext *ctx, LCAIndexKind kind);
+
+/// Returns the nearest common dominator of BBs a and b, the BB dominating
+/// both that is dominated by every other such BB, or -1 if a or b is
+/// unreachable from the entry. With CFGOptions::postDominators, it is also
+/// -1 if a and b lie in different trees of the forest, where only the
+/// virtual exit post-dominates both.
+int cfg_context_common_dominator(const CFGContext *ctx, int a, int b);
+
+/// Returns the nearest common dominator of the numBBs BBs at bbs, or -1 if
+/// there are none or any of them is unreachable. This takes one query
+/// whatever the number of BBs.
+int cfg_context_common_dominator_of(const CFGContext *ctx, const int *bbs,
+                                    int numBBs);
+
+/// Reports the memory of ctx's arena, which holds everything sized once
+/// a CFG is parsed, from the CSR arrays to the scratch memory of the
+/// dominance engines.
+void cfg_context_arena_stats(const CFGContext *ctx, ArenaStats *stats);
+
+void cfg_context_destroy(CFGContext *ctx);
+
+/// Analyses all the CFGs of the spec in in (which may hold several CFGs
+/// separated by '@' delimiter lines) and prints them to opts->outputFd.
+/// Returns 1 on success and 0, after printing the reason to stderr, if in
+/// cannot be read, holds an invalid binary CFG or a spec the strtok parser
+/// rejects, or the analysis cannot be written.
+int parse_cgf_from_file(FILE *in, const CFGOptions *opts);
+
+#endif
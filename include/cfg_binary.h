@@ -0,0 +1,111 @@
+#ifndef IBN_KHALDUN_CFG_BINARY_H
+#define IBN_KHALDUN_CFG_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// A binary CFG file holds a parsed CFG in the same compressed sparse row
+// (CSR) layout the analysis works on, so that it can be memory-mapped and
+// used in place instead of being parsed. All fields are little-endian
+// 32-bit integers laid out back to back:
+//
+//   CFGBinaryHeader
+//   succOffsets[numBBs+1]  succs of BB i are succs[succOffsets[i]] ..
+//   succs[numEdges]        succs[succOffsets[i+1]-1], in input order
+//   predOffsets[numBBs+1]  likewise for the preds of each BB, which must
+//   preds[numEdges]        be the BBs with an edge to it, in any order
+//   ids[numBBs]            original BBIDs, only if CFG_BINARY_HAS_IDS
+//
+// BBs are numbered 0 .. numBBs-1. Files without ids use these numbers as
+// BBIDs, which is what writers do when BB i has BBID i anyway.
+#define CFG_BINARY_MAGIC   "\x89IKCFG\r\n"
+#define CFG_BINARY_VERSION 1
+
+// Flags of CFGBinaryHeader::flags.
+#define CFG_BINARY_HAS_IDS 0x1
+
+typedef struct CFGBinaryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t numBBs;
+  uint32_t numEdges;
+  // The BB dominance is computed from. Version 1 requires it to be BB 0,
+  // as in CFGs parsed from text.
+  uint32_t entry;
+  uint32_t reserved;
+} CFGBinaryHeader;
+
+// The dominance information of a CFG is written in a similar format, as a
+// record per CFG. Records are simply concatenated, and each is laid out as
+//
+//   CFGResultHeader
+//   name[nameSize]         the CFG's delimiter line, padded with zeros
+//   ids[numBBs]            BBIDs
+//   idoms[numBBs]          BB number of the IDOM of each BB
+//   depths[numBBs]         depth of each BB in the dominator tree
+//   rpo[numReachable]      the BBs reachable from the entry BB 0 in
+//                          reverse-post-order
+//
+// where the BBs are numbered in the order their BBIDs first appear in the
+// spec, as in binary CFG files. Unreachable BBs have an IDOM and a depth of
+// -1, and the entry is its own IDOM with depth 0.
+//
+// If flags has CFG_RESULT_POST_DOMINATORS, the record holds post-dominators
+// instead (see CFGOptions::postDominators): idoms are IPDOMs, depths are in
+// the post-dominator forest, and rpo holds the BBs reaching an exit in
+// reverse-post-order of the reverse CFG. BBs that no other BB
+// post-dominates, the exits among them, are the roots of the forest: each
+// is its own IPDOM with depth 0. BBs reaching no exit have an IPDOM and a
+// depth of -1.
+#define CFG_RESULT_MAGIC   "\x89IKDOM\r\n"
+#define CFG_RESULT_VERSION 2
+
+// Flags of a result record.
+#define CFG_RESULT_POST_DOMINATORS 0x1u
+
+typedef struct CFGResultHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t numBBs;
+  uint32_t numReachable;
+  // A multiple of 4, 0 for an unnamed CFG.
+  uint32_t nameSize;
+} CFGResultHeader;
+
+/// The arrays of a binary CFG, pointing into the file's memory.
+typedef struct CFGBinaryView {
+  int32_t numBBs;
+  int32_t numEdges;
+  const int32_t *succOffsets;
+  const int32_t *succs;
+  const int32_t *predOffsets;
+  const int32_t *preds;
+  // NULL if the file has no BBIDs.
+  const int32_t *ids;
+} CFGBinaryView;
+
+/// Returns 1 if the size bytes at data start with the binary CFG magic,
+/// even if they are too short to hold a header.
+int cfg_binary_is_binary(const void *data, size_t size);
+
+/// Points the arrays of view into the binary CFG stored in the size bytes
+/// at data, which must be 4-byte aligned. Returns NULL on success and a
+/// description of the problem if data is not a valid binary CFG.
+const char *cfg_binary_view(const void *data, size_t size,
+                            CFGBinaryView *view);
+
+/// Writes the CFG of view to out in the binary format. If view->ids is NULL,
+/// the file gets no BBIDs. Returns 1 on success and 0 on a write error.
+int cfg_binary_write(FILE *out, const CFGBinaryView *view);
+
+/// Fills in header for a result record with flags of numBBs BBs,
+/// numReachable of which are reachable, whose CFG's delimiter line is
+/// nameLength bytes long.
+void cfg_result_init_header(CFGResultHeader *header, uint32_t flags,
+                            int32_t numBBs, int32_t numReachable,
+                            int nameLength);
+
+#endif
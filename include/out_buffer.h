@@ -0,0 +1,109 @@
+#ifndef IBN_KHALDUN_OUT_BUFFER_H
+#define IBN_KHALDUN_OUT_BUFFER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// A buffer collecting the output of the analysis, so that printing a BB
+// costs a few copies into memory instead of a stdio call per ID and per
+// separator. Once OUT_BUFFER_FLUSH_SIZE bytes are pending, they are handed
+// to the sink in a single write: a file descriptor (written with write(2),
+// bypassing stdio), a FILE, or none at all, in which case the buffer grows
+// to hold the whole output for its owner to take with out_buffer_detach.
+#define OUT_BUFFER_FLUSH_SIZE (1 << 20)
+// A FILE buffers on its own, so for FILE sinks the buffer only needs to
+// save calls into stdio and is flushed at this size instead. It stays
+// small enough for malloc to recycle, so that contexts created and
+// destroyed one after the other do not grow the heap.
+#define OUT_BUFFER_FILE_FLUSH_SIZE (1 << 12)
+// The initial size of buffers without a sink.
+#define OUT_BUFFER_MIN_SIZE   (1 << 12)
+// The most characters an int is printed with: a minus and 10 digits.
+#define OUT_BUFFER_INT_SIZE   11
+
+typedef struct OutBuffer {
+  char *data;
+  size_t size;
+  size_t capacity;
+  // The sink: fd if it is not -1, else file if it is not NULL.
+  int fd;
+  FILE *file;
+  // Set once a write to the sink failed. Later output is dropped.
+  int failed;
+} OutBuffer;
+
+// "00", "01", .. "99", so that ints are printed two digits at a time.
+extern const char outBufferDigitPairs[200];
+
+/// Initializes out with the sink fd, or file if fd is -1, or no sink if
+/// file is NULL too.
+void out_buffer_init(OutBuffer *out, int fd, FILE *file);
+
+/// Flushes out to its current sink and switches to the sink given as in
+/// out_buffer_init.
+void out_buffer_set_sink(OutBuffer *out, int fd, FILE *file);
+
+/// Writes the pending bytes of out to its sink, if it has one. Returns 1 if
+/// every write to the sink so far succeeded and 0 otherwise.
+int out_buffer_flush(OutBuffer *out);
+
+/// Returns the bytes collected by a buffer without a sink and stores their
+/// number in size. The caller owns the memory (to be released with free)
+/// and out starts over empty.
+char *out_buffer_detach(OutBuffer *out, size_t *size);
+
+/// Flushes out and frees its memory.
+void out_buffer_release(OutBuffer *out);
+
+/// Writes the n bytes at s when they do not fit in the buffer.
+void out_buffer_write_slow(OutBuffer *out, const char *s, size_t n);
+
+static inline void out_buffer_write(OutBuffer *out, const char *s, size_t n) {
+  // Empty writes, e.g. of a worker's output for a CFG without BBs, may
+  // come with a NULL s while data is NULL too, which memcpy must not see.
+  if (n == 0) {
+    return;
+  }
+
+  if (n > out->capacity - out->size) {
+    out_buffer_write_slow(out, s, n);
+    return;
+  }
+
+  __builtin_memcpy(out->data + out->size, s, n);
+  out->size += n;
+}
+
+// Writes the string literal s without measuring it at run time.
+#define out_buffer_put_literal(out, s)          \
+  out_buffer_write((out), (s), sizeof(s) - 1)
+
+/// Writes value in decimal. The digits are produced two at a time from the
+/// end into a small buffer, without the format parsing of printf.
+static inline void out_buffer_put_int(OutBuffer *out, int value) {
+  char digits[OUT_BUFFER_INT_SIZE];
+  char *end = digits + OUT_BUFFER_INT_SIZE;
+  char *p = end;
+  unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+
+  while (magnitude >= 100) {
+    p -= 2;
+    __builtin_memcpy(p, &outBufferDigitPairs[2 * (magnitude % 100)], 2);
+    magnitude /= 100;
+  }
+
+  if (magnitude >= 10) {
+    p -= 2;
+    __builtin_memcpy(p, &outBufferDigitPairs[2 * magnitude], 2);
+  } else {
+    *--p = '0' + magnitude;
+  }
+
+  if (value < 0) {
+    *--p = '-';
+  }
+
+  out_buffer_write(out, p, end - p);
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef IBN_KHALDUN_SPEC_SCAN_H
+#define IBN_KHALDUN_SPEC_SCAN_H
+
+#include <stdint.h>
+
+// Classification of CFG spec text in fixed size blocks. Each block of
+// SPEC_BLOCK_SIZE bytes is turned into bit masks with one bit per byte (bit
+// i stands for byte i of the block) so that a parser can jump straight from
+// one interesting byte to the next instead of looking at every byte.
+#define SPEC_BLOCK_SIZE 64
+
+typedef struct SpecBlockMasks {
+  // Bytes that can be part of a BB ID: digits and '-'.
+  uint64_t idChars;
+  // The '-' bytes among idChars. IDs are almost never negative, so runs of
+  // ID characters without one can take the fast digits-only path.
+  uint64_t minuses;
+  uint64_t newlines;
+  // '!' bytes, which start a comment running to the end of the line.
+  uint64_t comments;
+} SpecBlockMasks;
+
+// Kernels used for spec_classify_block. The widest one supported by the
+// CPU is selected at program startup.
+typedef enum SpecScanImpl {
+  SPEC_SCAN_IMPL_SCALAR,
+  SPEC_SCAN_IMPL_AVX2,
+  SPEC_SCAN_IMPL_AVX512,
+} SpecScanImpl;
+
+/// Returns 1 if the kernel of impl can run on this CPU and 0 otherwise.
+int spec_scan_impl_supported(SpecScanImpl impl);
+
+/// Switches to the kernel of impl. Returns 0 (and leaves the current kernel
+/// in place) if it is not supported.
+int spec_scan_use_impl(SpecScanImpl impl);
+
+SpecScanImpl spec_scan_current_impl(void);
+const char *spec_scan_impl_name(SpecScanImpl impl);
+
+/// Classifies the SPEC_BLOCK_SIZE bytes starting at block.
+void spec_classify_block(const char *block, SpecBlockMasks *masks);
+
+/// Converts the run of len (at most 8) decimal digits starting at p, all
+/// 8 bytes of which must be readable, without a loop over the digits: the
+/// digits are loaded as one word, and pairs, quads and octets of digits
+/// are combined with three multiplications (little-endian only).
+static inline uint32_t spec_parse_digits(const char *p, int len) {
+  uint64_t word;
+
+  __builtin_memcpy(&word, p, sizeof(word));
+
+  // Keep the digit values and move them to the top of the word so that the
+  // bytes shifted in below them act as leading zeros.
+  word = (word & 0x0f0f0f0f0f0f0f0full) << (8 * (8 - len));
+  word = (word * 10 + (word >> 8)) & 0x00ff00ff00ff00ffull;
+  word = (word * 100 + (word >> 16)) & 0x0000ffff0000ffffull;
+  word = (word * 10000 + (word >> 32)) & 0x00000000ffffffffull;
+  return (uint32_t)word;
+}
+
+#endif
@@ -0,0 +1,144 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/arena.h"
+
+#define align_up(n, alignment)                          \
+  (((n) + (alignment) - 1) & ~(size_t)((alignment) - 1))
+
+struct ArenaBlock {
+  ArenaBlock *next;
+  size_t size;
+};
+
+// Allocations start at the first aligned offset past the block header.
+#define ARENA_HEADER_SIZE align_up(sizeof(ArenaBlock), ARENA_ALIGNMENT)
+
+static ArenaBlock *arena_next_block(Arena *arena, size_t size);
+
+void arena_init(Arena *arena) {
+  arena->blocks = NULL;
+  arena->current = NULL;
+  arena->currentOffset = 0;
+  arena->usedBefore = 0;
+  arena->highWater = 0;
+  arena->reserved = 0;
+  arena->numBlocks = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+  size = align_up(size > 0 ? size : 1, ARENA_ALIGNMENT);
+
+  if (arena->current == NULL
+      || arena->current->size - arena->currentOffset < size) {
+    arena->usedBefore += arena->currentOffset;
+    arena->current = arena_next_block(arena, size);
+    arena->currentOffset = 0;
+  }
+
+  char *p = (char *)arena->current + ARENA_HEADER_SIZE
+    + arena->currentOffset;
+  arena->currentOffset += size;
+
+  size_t used = arena->usedBefore + arena->currentOffset;
+  if (used > arena->highWater) {
+    arena->highWater = used;
+  }
+
+  return p;
+}
+
+void *arena_grow(Arena *arena, void *p, size_t oldSize, size_t newSize) {
+  size_t oldAligned = align_up(oldSize, ARENA_ALIGNMENT);
+  size_t newAligned = align_up(newSize, ARENA_ALIGNMENT);
+
+  if (p != NULL && arena->current != NULL
+      && (char *)p + oldAligned == (char *)arena->current + ARENA_HEADER_SIZE
+         + arena->currentOffset
+      && arena->current->size - (arena->currentOffset - oldAligned)
+         >= newAligned) {
+    arena->currentOffset += newAligned - oldAligned;
+
+    size_t used = arena->usedBefore + arena->currentOffset;
+    if (used > arena->highWater) {
+      arena->highWater = used;
+    }
+
+    return p;
+  }
+
+  void *q = arena_alloc(arena, newSize);
+  if (oldSize > 0) {
+    memcpy(q, p, oldSize < newSize ? oldSize : newSize);
+  }
+
+  return q;
+}
+
+/// Returns the first block after the current one with room for size bytes.
+/// Blocks too small for size are skipped until the next reset. If there is
+/// none, a new block is inserted after the current one. New blocks are at
+/// least as large as all the existing ones together, so that a CFG much
+/// larger than the previous ones needs only a few new blocks.
+static ArenaBlock *arena_next_block(Arena *arena, size_t size) {
+  ArenaBlock *block = arena->current != NULL
+    ? arena->current->next : arena->blocks;
+
+  while (block != NULL && block->size < size) {
+    block = block->next;
+  }
+
+  if (block != NULL) {
+    return block;
+  }
+
+  size_t blockSize = size > arena->reserved ? size : arena->reserved;
+  if (blockSize < ARENA_MIN_BLOCK_SIZE) {
+    blockSize = ARENA_MIN_BLOCK_SIZE;
+  }
+
+  void *memory = NULL;
+  int error = posix_memalign(&memory, ARENA_ALIGNMENT,
+                             ARENA_HEADER_SIZE + blockSize);
+  assert(error == 0 && "Ran out of virtual memory\n");
+
+  block = memory;
+  block->size = blockSize;
+  if (arena->current != NULL) {
+    block->next = arena->current->next;
+    arena->current->next = block;
+  } else {
+    block->next = arena->blocks;
+    arena->blocks = block;
+  }
+
+  arena->reserved += blockSize;
+  arena->numBlocks++;
+  return block;
+}
+
+void arena_reset(Arena *arena) {
+  arena->current = NULL;
+  arena->currentOffset = 0;
+  arena->usedBefore = 0;
+}
+
+void arena_release(Arena *arena) {
+  ArenaBlock *block = arena->blocks;
+
+  while (block != NULL) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  arena_init(arena);
+}
+
+void arena_stats(const Arena *arena, ArenaStats *stats) {
+  stats->used = arena->usedBefore + arena->currentOffset;
+  stats->highWater = arena->highWater;
+  stats->reserved = arena->reserved;
+  stats->numBlocks = arena->numBlocks;
+}
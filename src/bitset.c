@@ -0,0 +1,243 @@
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITSET_HAS_X86_KERNELS 1
+#endif
+
+#include "../include/bitset.h"
+
+typedef void (*BitsetAndFn)(BitsetWord *, const BitsetWord *, size_t);
+typedef int (*BitsetEqualFn)(const BitsetWord *, const BitsetWord *, size_t);
+
+static void bitset_and_scalar(BitsetWord *dest, const BitsetWord *src,
+                              size_t numWords);
+static int bitset_equal_scalar(const BitsetWord *a, const BitsetWord *b,
+                               size_t numWords);
+static void bitset_select_impl(void) __attribute__((constructor));
+
+// The kernels used by bitset_and and bitset_equal. They start out as the
+// scalar ones and are switched to the widest vector kernels the CPU
+// supports at program startup.
+static BitsetImpl currentImpl = BITSET_IMPL_SCALAR;
+static BitsetAndFn andKernel = bitset_and_scalar;
+static BitsetEqualFn equalKernel = bitset_equal_scalar;
+
+void bitset_fill(BitsetWord *set, size_t numBits) {
+  size_t numWords = bitset_num_words(numBits);
+  memset(set, 0xff, numWords * sizeof(BitsetWord));
+
+  // Keep the bits past the end of the set cleared so that counting and
+  // comparing whole words stays exact.
+  if (numBits % BITSET_WORD_BITS != 0) {
+    set[numWords-1] = ((BitsetWord)1 << (numBits % BITSET_WORD_BITS)) - 1;
+  }
+}
+
+void bitset_and(BitsetWord *dest, const BitsetWord *src, size_t numWords) {
+  andKernel(dest, src, numWords);
+}
+
+int bitset_equal(const BitsetWord *a, const BitsetWord *b, size_t numWords) {
+  return equalKernel(a, b, numWords);
+}
+
+size_t bitset_count(const BitsetWord *set, size_t numWords) {
+  size_t count = 0;
+
+  for (size_t i=0 ; i<numWords ; i++) {
+    count += __builtin_popcountll(set[i]);
+  }
+
+  return count;
+}
+
+static void bitset_and_scalar(BitsetWord *dest, const BitsetWord *src,
+                              size_t numWords) {
+  for (size_t i=0 ; i<numWords ; i++) {
+    dest[i] &= src[i];
+  }
+}
+
+static int bitset_equal_scalar(const BitsetWord *a, const BitsetWord *b,
+                               size_t numWords) {
+  BitsetWord diff = 0;
+
+  // No early exit: sets compared here usually differ in a few words only,
+  // and a branch-free loop is cheaper than a mispredicted exit.
+  for (size_t i=0 ; i<numWords ; i++) {
+    diff |= a[i] ^ b[i];
+  }
+
+  return diff == 0;
+}
+
+#ifdef BITSET_HAS_X86_KERNELS
+
+// The vector kernels handle as many full vectors as fit in the sets and
+// leave the remaining words to the scalar kernels. Unaligned loads and
+// stores are used throughout since sets are packed back to back and so are
+// only guaranteed to be word aligned.
+
+__attribute__((target("avx2")))
+static void bitset_and_avx2(BitsetWord *dest, const BitsetWord *src,
+                            size_t numWords) {
+  size_t i = 0;
+
+  for ( ; i+8 <= numWords ; i+=8) {
+    __m256i d0 = _mm256_loadu_si256((const __m256i *)(dest + i));
+    __m256i d1 = _mm256_loadu_si256((const __m256i *)(dest + i + 4));
+    __m256i s0 = _mm256_loadu_si256((const __m256i *)(src + i));
+    __m256i s1 = _mm256_loadu_si256((const __m256i *)(src + i + 4));
+    _mm256_storeu_si256((__m256i *)(dest + i), _mm256_and_si256(d0, s0));
+    _mm256_storeu_si256((__m256i *)(dest + i + 4), _mm256_and_si256(d1, s1));
+  }
+
+  bitset_and_scalar(dest + i, src + i, numWords - i);
+}
+
+__attribute__((target("avx2")))
+static int bitset_equal_avx2(const BitsetWord *a, const BitsetWord *b,
+                             size_t numWords) {
+  __m256i diff = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for ( ; i+4 <= numWords ; i+=4) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+    diff = _mm256_or_si256(diff, _mm256_xor_si256(va, vb));
+  }
+
+  return _mm256_testz_si256(diff, diff)
+    && bitset_equal_scalar(a + i, b + i, numWords - i);
+}
+
+__attribute__((target("avx512f")))
+static void bitset_and_avx512(BitsetWord *dest, const BitsetWord *src,
+                              size_t numWords) {
+  size_t i = 0;
+
+  for ( ; i+16 <= numWords ; i+=16) {
+    __m512i d0 = _mm512_loadu_si512(dest + i);
+    __m512i d1 = _mm512_loadu_si512(dest + i + 8);
+    __m512i s0 = _mm512_loadu_si512(src + i);
+    __m512i s1 = _mm512_loadu_si512(src + i + 8);
+    _mm512_storeu_si512(dest + i, _mm512_and_si512(d0, s0));
+    _mm512_storeu_si512(dest + i + 8, _mm512_and_si512(d1, s1));
+  }
+
+  if (i+8 <= numWords) {
+    __m512i d = _mm512_loadu_si512(dest + i);
+    __m512i s = _mm512_loadu_si512(src + i);
+    _mm512_storeu_si512(dest + i, _mm512_and_si512(d, s));
+    i += 8;
+  }
+
+  // The last few words are done with a masked operation instead of the
+  // scalar loop.
+  if (i < numWords) {
+    __mmask8 mask = (1u << (numWords - i)) - 1;
+    __m512i d = _mm512_maskz_loadu_epi64(mask, dest + i);
+    __m512i s = _mm512_maskz_loadu_epi64(mask, src + i);
+    _mm512_mask_storeu_epi64(dest + i, mask, _mm512_and_si512(d, s));
+  }
+}
+
+__attribute__((target("avx512f")))
+static int bitset_equal_avx512(const BitsetWord *a, const BitsetWord *b,
+                               size_t numWords) {
+  __m512i diff = _mm512_setzero_si512();
+  size_t i = 0;
+
+  for ( ; i+8 <= numWords ; i+=8) {
+    __m512i va = _mm512_loadu_si512(a + i);
+    __m512i vb = _mm512_loadu_si512(b + i);
+    diff = _mm512_or_si512(diff, _mm512_xor_si512(va, vb));
+  }
+
+  if (i < numWords) {
+    __mmask8 mask = (1u << (numWords - i)) - 1;
+    __m512i va = _mm512_maskz_loadu_epi64(mask, a + i);
+    __m512i vb = _mm512_maskz_loadu_epi64(mask, b + i);
+    diff = _mm512_or_si512(diff, _mm512_xor_si512(va, vb));
+  }
+
+  return _mm512_test_epi64_mask(diff, diff) == 0;
+}
+
+#endif
+
+int bitset_impl_supported(BitsetImpl impl) {
+  switch (impl) {
+  case BITSET_IMPL_SCALAR:
+    return 1;
+#ifdef BITSET_HAS_X86_KERNELS
+  case BITSET_IMPL_AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  case BITSET_IMPL_AVX512:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+#else
+  default:
+    return 0;
+#endif
+  }
+
+  return 0;
+}
+
+int bitset_use_impl(BitsetImpl impl) {
+  if (!bitset_impl_supported(impl)) {
+    return 0;
+  }
+
+  switch (impl) {
+  case BITSET_IMPL_SCALAR:
+    andKernel = bitset_and_scalar;
+    equalKernel = bitset_equal_scalar;
+    break;
+#ifdef BITSET_HAS_X86_KERNELS
+  case BITSET_IMPL_AVX2:
+    andKernel = bitset_and_avx2;
+    equalKernel = bitset_equal_avx2;
+    break;
+  case BITSET_IMPL_AVX512:
+    andKernel = bitset_and_avx512;
+    equalKernel = bitset_equal_avx512;
+    break;
+#else
+  default:
+    return 0;
+#endif
+  }
+
+  currentImpl = impl;
+  return 1;
+}
+
+BitsetImpl bitset_current_impl(void) {
+  return currentImpl;
+}
+
+const char *bitset_impl_name(BitsetImpl impl) {
+  switch (impl) {
+  case BITSET_IMPL_SCALAR:
+    return "scalar";
+  case BITSET_IMPL_AVX2:
+    return "avx2";
+  case BITSET_IMPL_AVX512:
+    return "avx512";
+  }
+
+  return "unknown";
+}
+
+/// Picks the widest kernels supported by the CPU (as reported by CPUID).
+static void bitset_select_impl(void) {
+  if (!bitset_use_impl(BITSET_IMPL_AVX512)) {
+    if (!bitset_use_impl(BITSET_IMPL_AVX2)) {
+      bitset_use_impl(BITSET_IMPL_SCALAR);
+    }
+  }
+}
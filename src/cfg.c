@@ -4,14 +4,32 @@
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <time.h>
 
-#define MAX_SUCCESSORS    16
-#define MAX_PREDECESSORS  16
-#define MAX_DOMINATORS    128
-#define MAX_SPEC_LINE_LEN 128
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 
-#define log(msg, ...)                           \
-  fprintf(stdout, (msg), ## __VA_ARGS__)
+#include "../include/arena.h"
+#include "../include/bitset.h"
+#include "../include/cfg.h"
+#include "../include/cfg_binary.h"
+#include "../include/out_buffer.h"
+#include "../include/spec_scan.h"
+
+#define MAX_SPEC_LINE_LEN 128
+// Chunk size used to read inputs that cannot be memory-mapped.
+#define INPUT_READ_CHUNK  (1 << 20)
+// Inputs are not split across threads into chunks smaller than this, as
+// starting a thread and merging its chunk would cost more than parsing it.
+#define MIN_PARSE_CHUNK   (1 << 18)
 
 // Avoid doule evaluation by using GCC's __auto_type feature
 // https://gcc.gnu.org/onlinedocs/gcc-4.9.2/gcc/Typeof.html#Typeof
@@ -28,280 +46,2848 @@ typedef int bool;
 #define TRUE  1
 #define FALSE 0
 
-typedef struct CFGNode {
-  BBID id;
-  // An array of pointer offsets into the global memory block allocated for
-  // all CFG nodes. The reason for storing indices rather than actual pointers
-  // is that I don't know the max expected number of BB in the input program
-  // and thus I use realloc which might move the originally allocated block
-  // to a different place in memory invalidating old pointers.
-  PoolOffset succs[MAX_SUCCESSORS];
-  int numSuccs;
-
-  PoolOffset preds[MAX_PREDECESSORS];
-  int numPreds;
+/// The interval of a BB in a preorder numbering of the dominator tree: the
+/// BBs it dominates (itself included) are the ones numbered pre ..
+/// pre+size-1. Every dominance query reads both fields of a BB, so they are
+/// stored together rather than as parallel arrays.
+typedef struct DomInterval {
+  int pre;
+  int size;
+} DomInterval;
+
+/// The pool of CFG nodes. Nodes are stored as parallel arrays indexed by
+/// PoolOffset rather than as an array of structs, so that each pass only
+/// streams through the fields it actually reads. The succ and pred ranges
+/// of the nodes are the CSR offset arrays below.
+typedef struct CFGNodePool {
+  BBID *ids;
+
+  // The immediate dominator of each BB (the entry BB is its own immediate
+  // dominator) or UNDEFINED if the BB is unreachable from the entry. With
+  // CFGOptions::postDominators, it is the immediate post-dominator, and
+  // BBs post-dominated by no other BB (the exits among them) are their
+  // own.
+  PoolOffset *idoms;
+  // The depth of each BB in the dominator tree (0 for the entry BB) or
+  // UNDEFINED, only computed for the output formats that print it.
+  int *domDepths;
+  // Filled by number_dom_tree for the queries of cfg_context_dominates.
+  // BBs unreachable from the entry have a pre of UNDEFINED and a size of 0.
+  DomInterval *domIntervals;
+  // Numbers of each BB in the depth-first traversal of the CFG from the
+  // entry BB: its preorder, postorder and reverse-post-order (RPO) index
+  // and its parent in the DFS tree. All are UNDEFINED for BBs unreachable
+  // from the entry (and the entry has no DFS parent).
+  int *preNumbers;
+  int *postNumbers;
+  int *rpoNumbers;
+  PoolOffset *dfsParents;
+} CFGNodePool;
+
+#define UNDEFINED (-1)
 
-  // dominators of the BB
-  PoolOffset doms[MAX_DOMINATORS];
-  int numDoms;
-} CFGNode, *CFGNodePtr;
-
-// The entry BB is stored as the first object of the pool.
-static CFGNodePtr cfgNodePool = NULL;
-static int currentPoolSize = 0;
-static int currentNumCFGNodes = 0;
-static char cfgSpecLine[MAX_SPEC_LINE_LEN];
-
-static PoolOffset get_cfg_node_for_bb(BBID bbID);
-static void release_memory(CFGNodePtr bb);
-static void calculate_dominance();
-static void calculate_reverse_post_order(PoolOffset bbOffset, int *pot,
-                                      int *rpot, bool *visited);
-static bool update_dom_set(PoolOffset bbOffset);
-static void intersect_dom_sets(PoolOffset *dest, int *destSize,
-                             PoolOffset *src, int *srcSize);
-static void print_cfg_node(PoolOffset bbOffset);
-static void print_dom_set(char* setName, PoolOffset* set, int setSize);
-
-void parse_cgf_from_file(FILE *in) {
-  if (cfgNodePool != NULL) {
-    release_memory(cfgNodePool);
-    free(cfgNodePool);
+/// The whole input CFG spec as one contiguous, read-only block of memory.
+/// Regular files are memory-mapped; anything else (e.g. a pipe on stdin) is
+/// read into a heap buffer.
+typedef struct InputBuffer {
+  const char *data;
+  size_t size;
+  bool mapped;
+} InputBuffer;
+
+/// The BBs and edges parsed from (a part of) a CFG spec. BBs are numbered
+/// in the order their IDs first appear in the spec and edges are kept in
+/// spec order.
+///
+/// The index is an open addressing hash index mapping a BBID to the
+/// PoolOffset of its BB. Slots hold PoolOffsets (or EMPTY_SLOT) and the key
+/// of a slot is read back from ids so the index stays valid when ids is
+/// realloc'ed. The capacity is always a power of 2 and is kept at least
+/// twice the number of BBs so that linear probing stays short.
+typedef struct SpecTable {
+  // Where the arrays are allocated, or NULL for the heap.
+  Arena *arena;
+  BBID *ids;
+  int numBBs;
+  int idCapacity;
+  PoolOffset *index;
+  int indexCapacity;
+  PoolOffset *edgeSrcs;
+  PoolOffset *edgeDests;
+  int numEdges;
+  int edgeCapacity;
+} SpecTable;
+
+/// A range of lines of the spec parsed by one thread into its own table.
+typedef struct SpecChunk {
+  const char *begin;
+  const char *end;
+  CFGParser parser;
+  SpecTable table;
+} SpecChunk;
+
+/// State of the Lengauer-Tarjan algorithm. All arrays are indexed by DFS
+/// (preorder) numbers which start at 1 so that 0 can stand for "no vertex",
+/// as in the original paper. The DFS number of a BB is thus its preorder
+/// number in the pool plus one.
+typedef struct LTState {
+  PoolOffset *vertex; // DFS number -> PoolOffset
+  int *parent;
+  int *semi;
+  int *label;
+  int *ancestor;
+  int *child;
+  int *size;
+  int *dom;
+  // Buckets are singly linked lists threaded through bucketNext.
+  int *bucket;
+  int *bucketNext;
+  int *stack;
+} LTState;
+
+#define EMPTY_SLOT (-1)
+
+/// The graph the dominance engines run on, made of the CSR arrays of the
+/// CFG: the CFG itself, or for post-dominators its reverse, which swaps the
+/// succ and pred arrays rather than copying them. The reverse graph is
+/// entered from a virtual exit at offset numNodes-1, just past the BBs,
+/// whose succs are the BBs without succs in the CFG and which is the only
+/// pred of those BBs in the reverse graph. Its edges are the one thing not
+/// found in the CSR arrays, so the engines read edges through dom_graph_succs
+/// and dom_graph_preds.
+typedef struct DomGraph {
+  const int *succOffsets;
+  const PoolOffset *succs;
+  const int *predOffsets;
+  const PoolOffset *preds;
+  PoolOffset entry;
+  int numNodes;
+  // UNDEFINED unless the graph is the reverse CFG.
+  PoolOffset virtualExit;
+  PoolOffset *exits;
+  int numExits;
+} DomGraph;
+
+/// Returns the succs of the node bb of graph and stores their number in
+/// numSuccs.
+static inline const PoolOffset *dom_graph_succs(const DomGraph *graph,
+                                                PoolOffset bb,
+                                                int *numSuccs) {
+  if (bb == graph->virtualExit) {
+    *numSuccs = graph->numExits;
+    return graph->exits;
   }
 
-  while (fgets(cfgSpecLine, MAX_SPEC_LINE_LEN, in) != NULL) {
-    char *tok = strtok(cfgSpecLine, " \n\t:");
+  int first = graph->succOffsets[bb];
+  *numSuccs = graph->succOffsets[bb+1] - first;
+  return graph->succs + first;
+}
 
-    if (tok == NULL || *tok == '!') {
-      continue;
-    }
+/// Returns the preds of the node bb of graph and stores their number in
+/// numPreds.
+static inline const PoolOffset *dom_graph_preds(const DomGraph *graph,
+                                                PoolOffset bb,
+                                                int *numPreds) {
+  if (bb == graph->virtualExit) {
+    *numPreds = 0;
+    return NULL;
+  }
 
-    BBID srcBBID = strtol(tok, NULL, 10);
-    PoolOffset srcBBOffset = get_cfg_node_for_bb(srcBBID);
-    CFGNodePtr srcBB = cfgNodePool + srcBBOffset;
+  int first = graph->predOffsets[bb];
+  *numPreds = graph->predOffsets[bb+1] - first;
+  if (*numPreds == 0 && graph->virtualExit != UNDEFINED) {
+    *numPreds = 1;
+    return &graph->virtualExit;
+  }
+  return graph->preds + first;
+}
 
-    while ((tok = strtok(NULL, " \n\t,")) != NULL) {
-      BBID destBBID = strtol(tok, NULL, 10);
-      PoolOffset destBBOffset = get_cfg_node_for_bb(destBBID);
-      CFGNodePtr destBB = cfgNodePool + destBBOffset;
+/// The index answering nearest common dominator queries on the dominator
+/// tree, see cfg_context_build_lca_index.
+typedef struct LCAIndex {
+  LCAIndexKind kind;
+  bool built;
+  // The reachable BBs by their preorder number in the dominator tree (see
+  // the pool's domIntervals), for the sparse table.
+  PoolOffset *domPreorder;
+  // The sparse table: row k holds, for every preorder number i, the
+  // smallest preorder number of the IDOMs of the BBs numbered i ..
+  // i+2^k-1 (as far as there are any), in rows of numReachable ints.
+  int *table;
+  int numLevels;
+  // The jump pointer of every BB, an ancestor in the dominator tree (see
+  // build_lca_jumps).
+  PoolOffset *jumps;
+} LCAIndex;
+
+/// All the state of the analysis of one CFG at a time. Nothing is shared
+/// between contexts, so each worker of a batch (see
+/// analyse_cfg_batch_in_parallel) analyses its CFGs in a context of its own.
+///
+/// The BBs and edges of the current CFG are parsed into cfgSpec and the
+/// pool's BBIDs are cfgSpec.ids. While parsing, edges are appended to
+/// cfgSpec.edgeSrcs and cfgSpec.edgeDests in input order. Once the whole CFG
+/// is parsed, they are copied into a compressed sparse row (CSR) layout:
+/// the succs of the BB at offset i are succs[succOffsets[i]] ..
+/// succs[succOffsets[i+1]-1], and likewise for preds.
+///
+/// Edges store offsets into the pool rather than actual pointers because
+/// the number of BBs in the input program is not known up front. The pool
+/// grows by moving to larger arrays, which invalidates old pointers.
+///
+/// All the memory of the CFG is owned by the arena: cfgSpec, the CSR
+/// arrays, the arrays of the pool filled by the analysis, the traversal
+/// orders and the scratch memory of the engines. Nothing is freed one by
+/// one; the arena is reset for each CFG and keeps its blocks, so that a
+/// batch of CFGs is analysed in the memory needed by the largest of them.
+struct CFGContext {
+  CFGOptions opts;
+  // Where the analysis prints the BBs.
+  OutBuffer out;
+  Arena arena;
+
+  // The entry BB is stored as the first object of the pool.
+  CFGNodePool cfgNodePool;
+  int currentPoolSize;
+  int currentNumCFGNodes;
+
+  // The BBs reachable from the entry in DFS preorder and in
+  // reverse-post-order.
+  PoolOffset *preorder;
+  PoolOffset *rpot;
+  int numReachableCFGNodes;
+
+  SpecTable cfgSpec;
+  int numParsedEdges;
+
+  int *succOffsets;
+  PoolOffset *succs;
+  int *predOffsets;
+  PoolOffset *preds;
+
+  // What calculate_dominance analyses. The arrays of the pool are sized
+  // for its nodes, virtual exit included, until the analysis removes it.
+  DomGraph domGraph;
+
+  LCAIndex lcaIndex;
+
+  // The binary CFG the CSR arrays point into, if the CFG was loaded from
+  // one (graphInput.data is NULL otherwise). The pool's BBIDs point into it
+  // too unless the file has none. It is owned by the caller.
+  InputBuffer graphInput;
+};
+
+/// Statistics summed over all the CFGs of an input.
+typedef struct CFGStats {
+  int numCFGs;
+  long numBBs;
+  long numEdges;
+  double parseTime;
+  double analysisTime;
+  long long parseMisses;
+  long long analysisMisses;
+  // The memory used by the largest CFG and its number of BBs.
+  size_t peakGraphSize;
+  int peakGraphBBs;
+  // The arena of the context that needed the most memory.
+  size_t arenaHighWater;
+  size_t arenaReserved;
+} CFGStats;
+
+/// One CFG of a batch: its part of the spec, its delimiter line (if any)
+/// and, when analysed by a worker, the output it produced.
+typedef struct CFGJob {
+  InputBuffer spec;
+  const char *name;
+  int nameLength;
+  char *output;
+  size_t outputSize;
+  bool done;
+} CFGJob;
+
+/// The jobs assigned to one worker. The worker takes them from the head,
+/// where the largest ones are, and idle workers steal from the tail.
+typedef struct JobDeque {
+  pthread_mutex_t lock;
+  int *jobs;
+  int head;
+  int tail;
+} JobDeque;
+
+typedef struct CFGWorkerPool {
+  const CFGOptions *opts;
+  CFGJob *jobs;
+  int numJobs;
+  JobDeque *deques;
+  int numWorkers;
+  // Signalled whenever a job is done.
+  pthread_mutex_t doneLock;
+  pthread_cond_t doneCond;
+} CFGWorkerPool;
+
+typedef struct CFGWorker {
+  CFGWorkerPool *pool;
+  int index;
+  CFGStats stats;
+} CFGWorker;
+
+static PoolOffset spec_table_intern(SpecTable *table, BBID bbID);
+static unsigned hash_bb_id(BBID bbID);
+static void spec_table_grow_index(SpecTable *table);
+static void spec_table_add_edge(SpecTable *table, PoolOffset srcBBOffset,
+                                PoolOffset destBBOffset);
+static void spec_table_merge(SpecTable *table, SpecTable *chunkTable);
+static void *spec_table_resize(SpecTable *table, void *p, size_t oldSize,
+                               size_t newSize);
+static void spec_table_reserve(SpecTable *table, int numBBs, int numEdges);
+static int count_spec_lines(const InputBuffer *input);
+static void use_parsed_spec(CFGContext *ctx);
+static void build_csr_graph(CFGContext *ctx);
+static size_t graph_memory_size(CFGContext *ctx);
+static double current_time_ms();
+static bool parse_cfg_with_strtok(FILE *in, SpecTable *table,
+                                  size_t *inputSize);
+static void parse_cfg_in_chunks(const InputBuffer *input, CFGParser parser,
+                                int numThreads, SpecTable *table);
+static bool parse_cfg_spec(CFGContext *ctx, const InputBuffer *input,
+                           int numThreads);
+static void parse_cfg_batch(CFGContext *ctx, const InputBuffer *input,
+                            int cacheMissCounter, CFGStats *stats);
+static void analyse_cfg_job(CFGContext *ctx, CFGJob *job, int numThreads,
+                            int cacheMissCounter, CFGStats *stats);
+static void analyse_cfg_batch_in_parallel(CFGContext *ctx, CFGJob *jobs,
+                                          int numJobs, CFGStats *stats);
+static void *run_cfg_worker(void *worker);
+static int take_cfg_job(CFGWorkerPool *pool, int workerIndex);
+static const char *find_cfg_delimiter(const char *begin, const char *p,
+                                      const char *end);
+static void finish_cfg(CFGContext *ctx, const char *name, int nameLength,
+                       int cacheMissCounter, double parseStart,
+                       long long parseStartMisses, CFGStats *stats);
+static void add_arena_stats(const CFGContext *ctx, CFGStats *stats);
+static bool map_cfg_binary(CFGContext *ctx, const InputBuffer *input);
+static void write_cfg_binary(CFGContext *ctx, FILE *out);
+static void reset_graph(CFGContext *ctx);
+static int compare_u64(const void *a, const void *b);
+static void *parse_spec_chunk(void *chunk);
+static void scan_spec(const char *p, const char *end, SpecTable *table);
+static void scan_spec_simd(const char *data, size_t size, SpecTable *table);
+static void add_spec_id_run(SpecTable *table, const char *p, const char *end,
+                            int runLength, bool hasMinus,
+                            PoolOffset *srcBBOffset);
+static void add_spec_bb(SpecTable *table, BBID bbID, PoolOffset *srcBBOffset);
+static bool load_input(FILE *in, InputBuffer *input);
+static void release_input(InputBuffer *input);
+static const char *scan_bb_id(const char *p, const char *end, BBID *bbID);
+static int open_cache_miss_counter();
+static long long read_counter(int fd);
+static void calculate_dominance(CFGContext *ctx);
+static void init_dom_graph(CFGContext *ctx);
+static void remove_virtual_exit(CFGContext *ctx);
+static void calculate_dominance_iterative(CFGContext *ctx, int *rpot,
+                                          int numReachable);
+static void calculate_dominance_chk(CFGContext *ctx, int *rpot,
+                                    int numReachable);
+static PoolOffset intersect_idoms(CFGContext *ctx, PoolOffset b1,
+                                  PoolOffset b2);
+static void calculate_dominance_lt(CFGContext *ctx, bool balanced);
+static void calculate_dominance_semi_nca(CFGContext *ctx);
+static int lt_init_dfs_tree(CFGContext *ctx, LTState *s);
+static void lt_compress(LTState *s, int v);
+static int lt_eval(LTState *s, int v, bool balanced);
+static void lt_link(LTState *s, int v, int w, bool balanced);
+static void allocate_analysis_arrays(CFGContext *ctx);
+static void calculate_dfs_orders(CFGContext *ctx);
+static bool update_dom_set(CFGContext *ctx, PoolOffset bbOffset,
+                           BitsetWord *domSets, BitsetWord *tempSet,
+                           size_t numWords);
+static int get_dom_set(CFGContext *ctx, PoolOffset bbOffset,
+                       PoolOffset *doms);
+static void print_cfg_node(CFGContext *ctx, PoolOffset bbOffset,
+                           PoolOffset *domsScratch);
+static void print_bb_list(CFGContext *ctx, const PoolOffset *bbOffsets,
+                          int numBBs);
+static void print_analysis(CFGContext *ctx, const char *name,
+                           int nameLength);
+static void print_idoms(CFGContext *ctx);
+static void print_json(CFGContext *ctx, const char *name, int nameLength);
+static void print_json_bb(CFGContext *ctx, PoolOffset bbOffset);
+static void print_json_array(CFGContext *ctx, const PoolOffset *bbOffsets,
+                             int numBBs);
+static void print_binary_result(CFGContext *ctx, const char *name,
+                                int nameLength);
+static void print_dot(CFGContext *ctx, const char *name, int nameLength);
+static void print_quoted(CFGContext *ctx, const char *s, int length);
+static void calculate_dom_depths(CFGContext *ctx);
+static void number_dom_tree(CFGContext *ctx);
+static void build_lca_table(CFGContext *ctx);
+static void build_lca_jumps(CFGContext *ctx);
+static PoolOffset lca_from_table(const CFGContext *ctx, int pre1, int pre2);
+static PoolOffset lca_by_jumps(const CFGContext *ctx, PoolOffset bb1,
+                               PoolOffset bb2);
+
+CFGContext *cfg_context_create(const CFGOptions *opts) {
+  CFGContext *ctx = calloc(1, sizeof(CFGContext));
+  assert(ctx != NULL && "Ran out of virtual memory\n");
+
+  ctx->opts = *opts;
+  out_buffer_init(&ctx->out, STDOUT_FILENO, NULL);
+  arena_init(&ctx->arena);
+  ctx->cfgSpec.arena = &ctx->arena;
+  return ctx;
+}
+
+int cfg_context_parse(CFGContext *ctx, const char *spec, size_t size) {
+  InputBuffer input = { spec, size, FALSE };
+
+  return parse_cfg_spec(ctx, &input, ctx->opts.numThreads);
+}
+
+void cfg_context_analyse(CFGContext *ctx, FILE *out) {
+  calculate_dominance(ctx);
+  number_dom_tree(ctx);
+  memset(&ctx->lcaIndex, 0, sizeof(ctx->lcaIndex));
+
+  if (out != NULL) {
+    out_buffer_set_sink(&ctx->out, -1, out);
+    print_analysis(ctx, NULL, 0);
+    out_buffer_flush(&ctx->out);
+  }
+}
+
+int cfg_context_num_bbs(const CFGContext *ctx) {
+  return ctx->currentNumCFGNodes;
+}
+
+int cfg_context_bb_id(const CFGContext *ctx, int bb) {
+  return ctx->cfgNodePool.ids[bb];
+}
+
+int cfg_context_idom(const CFGContext *ctx, int bb) {
+  return ctx->cfgNodePool.idoms[bb];
+}
+
+int cfg_context_dominates(const CFGContext *ctx, int a, int b) {
+  const DomInterval *intervals = ctx->cfgNodePool.domIntervals;
+
+  // A single unsigned compare checks both ends of a's interval. b's pre is
+  // UNDEFINED if it is unreachable, which wraps around to a huge distance.
+  return (unsigned)(intervals[b].pre - intervals[a].pre)
+    < (unsigned)intervals[a].size;
+}
+
+int cfg_context_strictly_dominates(const CFGContext *ctx, int a, int b) {
+  return a != b && cfg_context_dominates(ctx, a, b);
+}
+
+void cfg_context_build_lca_index(CFGContext *ctx, LCAIndexKind kind) {
+  LCAIndex *index = &ctx->lcaIndex;
 
-      srcBB->succs[srcBB->numSuccs] = destBBOffset;
-      srcBB->numSuccs++;
+  memset(index, 0, sizeof(*index));
+  index->kind = kind;
 
-      destBB->preds[destBB->numPreds] = srcBBOffset;
-      destBB->numPreds++;
+  switch (kind) {
+  case LCA_INDEX_SPARSE_TABLE:
+    build_lca_table(ctx);
+    break;
+  case LCA_INDEX_JUMP_POINTERS:
+    build_lca_jumps(ctx);
+    break;
+  }
+
+  index->built = TRUE;
+}
+
+int cfg_context_common_dominator(const CFGContext *ctx, int a, int b) {
+  const DomInterval *intervals = ctx->cfgNodePool.domIntervals;
+
+  assert(ctx->lcaIndex.built && "The LCA index is not built\n");
+  if (intervals[a].pre == UNDEFINED || intervals[b].pre == UNDEFINED) {
+    return UNDEFINED;
+  }
+
+  if (ctx->lcaIndex.kind == LCA_INDEX_SPARSE_TABLE) {
+    return lca_from_table(ctx, intervals[a].pre, intervals[b].pre);
+  }
+  return lca_by_jumps(ctx, a, b);
+}
+
+int cfg_context_common_dominator_of(const CFGContext *ctx, const int *bbs,
+                                    int numBBs) {
+  const DomInterval *intervals = ctx->cfgNodePool.domIntervals;
+
+  assert(ctx->lcaIndex.built && "The LCA index is not built\n");
+  if (numBBs == 0) {
+    return UNDEFINED;
+  }
+
+  // The nearest common dominator of a set of BBs is the one of the first
+  // and the last of them in preorder: any BB dominating both has the
+  // whole range between them in its subtree. So one query does.
+  PoolOffset first = bbs[0];
+  PoolOffset last = bbs[0];
+
+  for (int i=0 ; i<numBBs ; i++) {
+    int pre = intervals[bbs[i]].pre;
+
+    if (pre == UNDEFINED) {
+      return UNDEFINED;
+    }
+    if (pre < intervals[first].pre) {
+      first = bbs[i];
+    } else if (pre > intervals[last].pre) {
+      last = bbs[i];
     }
   }
 
-  calculate_dominance();
+  return cfg_context_common_dominator(ctx, first, last);
 }
 
-/// Calculate dominance information as described in Section 9.2.1 of
-/// "Engineering a compiler", 2011
-static void calculate_dominance() {
-  // The entry node only dominates itself
-  cfgNodePool[0].doms[0] = 0;
-  cfgNodePool[0].numDoms = 1;
-
-  for (int i=1 ; i<currentNumCFGNodes ; i++) {
-    // If the number of dominators of a BB is 0, then this BB is dominated
-    // by all other BBs. In other words, the number of dominators is
-    // actually currentNumCFGNodes.
-    //
-    // I did that since I use fixed sized arrays with max sizes. The
-    // dominators set of and BB starts huge (includes all the BBs in the
-    // CFG) during the initialization step and then shrinks. Instead of
-    // unnecessarily creating huge sets of dominators an empty dominator
-    // set signals an includes-all set
-    //
-    // This is fine since any BB at least dominates itself.
-    cfgNodePool[i].numDoms = 0;
-  }
-
-  int *rpot = malloc(currentNumCFGNodes * sizeof(int));
-  bool *visited = calloc(currentNumCFGNodes, sizeof(bool));
-  int pot = 0;
-  calculate_reverse_post_order(0, &pot, rpot, visited);
+void cfg_context_arena_stats(const CFGContext *ctx, ArenaStats *stats) {
+  arena_stats(&ctx->arena, stats);
+}
 
-  bool changed = TRUE;
+void cfg_context_destroy(CFGContext *ctx) {
+  out_buffer_release(&ctx->out);
+  arena_release(&ctx->arena);
+  free(ctx);
+}
 
-  while(changed) {
-    changed = FALSE;
+int parse_cgf_from_file(FILE *in, const CFGOptions *opts) {
+  CFGContext *ctx = cfg_context_create(opts);
+  bool ok = TRUE;
+  int cacheMissCounter = opts->printStats ? open_cache_miss_counter() : -1;
+  CFGStats stats = { 0 };
+  InputBuffer input;
+  size_t inputSize = 0;
+  bool isBinary = FALSE;
+  double parseStart = current_time_ms();
+  long long parseStartMisses = read_counter(cacheMissCounter);
+  double start = parseStart;
 
-    // Update the dom sets of BB's according to their reverse-post-order
-    // traversal.
-    for (int i=1 ; i<currentNumCFGNodes ; i++) {
-      changed |= update_dom_set(rpot[i]);
+  out_buffer_set_sink(&ctx->out, opts->outputFd, NULL);
+
+  switch (opts->parser) {
+  case CFG_PARSER_SIMD:
+  case CFG_PARSER_SCAN:
+    if (!load_input(in, &input)) {
+      ok = FALSE;
+      break;
+    }
+    inputSize = input.size;
+
+    // Binary CFGs are recognized by their magic and used in place.
+    isBinary = cfg_binary_is_binary(input.data, input.size);
+    if (isBinary) {
+      ok = parse_cfg_spec(ctx, &input, 1);
+      if (ok) {
+        finish_cfg(ctx, NULL, 0, cacheMissCounter, parseStart,
+                   parseStartMisses, &stats);
+      }
+    } else {
+      parse_cfg_batch(ctx, &input, cacheMissCounter, &stats);
+    }
+
+    // The CFG may point into the input.
+    reset_graph(ctx);
+    release_input(&input);
+    break;
+  case CFG_PARSER_STRTOK:
+    reset_graph(ctx);
+    ok = parse_cfg_with_strtok(in, &ctx->cfgSpec, &inputSize);
+    if (ok && ferror(in)) {
+      perror("Failed to read the input");
+      ok = FALSE;
     }
+    if (!ok) {
+      break;
+    }
+    use_parsed_spec(ctx);
+    build_csr_graph(ctx);
+    finish_cfg(ctx, NULL, 0, cacheMissCounter, parseStart,
+               parseStartMisses, &stats);
+    break;
+  }
+
+  if (!out_buffer_flush(&ctx->out)) {
+    fprintf(stderr, "Failed to write the analysis\n");
+    ok = FALSE;
   }
 
-  for (int i=0 ; i<currentNumCFGNodes ; i++) {
-    print_cfg_node(rpot[i]);
+  add_arena_stats(ctx, &stats);
+  cfg_context_destroy(ctx);
+
+  if (opts->printStats) {
+    double parseTime = stats.parseTime;
+    fprintf(stderr, "parse: %.3f ms, %ld blocks, %ld edges, %.1f ns/block\n",
+            parseTime, stats.numBBs, stats.numEdges,
+            stats.numBBs > 0 ? parseTime * 1e6 / stats.numBBs : 0.0);
+    fprintf(stderr, "input: %zu bytes, %.1f MB/s", inputSize,
+            parseTime > 0 ? inputSize / parseTime / 1e3 : 0.0);
+    if (isBinary) {
+      fprintf(stderr, " (binary)");
+    } else if (opts->parser == CFG_PARSER_SIMD) {
+      fprintf(stderr, " (%s)",
+              spec_scan_impl_name(spec_scan_current_impl()));
+    }
+    fprintf(stderr, "\n");
+    if (cacheMissCounter != -1) {
+      fprintf(stderr, "cache misses: parse %lld, analysis %lld\n",
+              stats.parseMisses, stats.analysisMisses);
+      close(cacheMissCounter);
+    } else {
+      fprintf(stderr, "cache misses: n/a\n");
+    }
+    fprintf(stderr, "graph: %zu bytes, %.1f bytes/block\n",
+            stats.peakGraphSize, stats.peakGraphBBs > 0
+            ? (double)stats.peakGraphSize / stats.peakGraphBBs : 0.0);
+    fprintf(stderr, "arena: %zu bytes high water, %zu bytes reserved\n",
+            stats.arenaHighWater, stats.arenaReserved);
+    fprintf(stderr, "analysis: %.3f ms\n", stats.analysisTime);
+    fprintf(stderr, "cfgs: %d in %.3f ms on %d threads\n", stats.numCFGs,
+            current_time_ms() - start, opts->numThreads);
   }
 
-  free(rpot);
-  free(visited);
+  return ok;
 }
 
-/// Updates the dominator set of the BB stored at bbOffset by taking the
-/// intersection of all dom sets of predecessors and adding the BB to the
-/// result if not already there.
-///
-/// Returns true if the dom set was changed and false otherwise.
+/// Parses and analyses all the CFGs of a spec. Every CFG but the first
+/// starts with a delimiter line, whose first non-blank character is '@' and
+/// the rest of which names the CFG. The first CFG is unnamed and is skipped
+/// if it has no BBs, so a spec of a single CFG needs no delimiter at all.
 ///
-/// FIXME: for now a very inefficient representation of sets and a poor
-/// implementation of union-find is provided. Implement a better solution
-/// by following e.g. Chapter 21 in CLRS. Probably start a repo for
-/// something like the STL.
-static bool update_dom_set(PoolOffset bbOffset) {
-  CFGNodePtr n = cfgNodePool + bbOffset;
-  int oldNumDoms = n->numDoms;
-  PoolOffset tempSet[MAX_DOMINATORS];
-  int tempSetSize = 0;
-  
-  for (int i=0 ; i<n->numPreds ; i++) {
-    CFGNodePtr pred = cfgNodePool + n->preds[i];
-    intersect_dom_sets(tempSet, &tempSetSize, pred->doms,
-                     &(pred->numDoms));
-  }
-
-  bool found = FALSE;
-  for (int i=0 ; i<tempSetSize ; i++) {
-    if (tempSet[i] == bbOffset) {
-      found = TRUE;
+/// With more than one thread and more than one CFG, the CFGs are analysed
+/// by a pool of workers (one per thread), otherwise one after the other,
+/// and the threads split the parsing of each CFG instead.
+static void parse_cfg_batch(CFGContext *ctx, const InputBuffer *input,
+                            int cacheMissCounter, CFGStats *stats) {
+  double splitStart = current_time_ms();
+  const char *end = input->data + input->size;
+  const char *cfgBegin = input->data;
+  const char *name = NULL;
+  int nameLength = 0;
+  CFGJob *jobs = NULL;
+  int numJobs = 0;
+  int jobCapacity = 0;
+
+  for (;;) {
+    const char *delimiter = find_cfg_delimiter(input->data, cfgBegin, end);
+
+    if (numJobs == jobCapacity) {
+      jobCapacity = max(16, 2 * jobCapacity);
+      jobs = realloc(jobs, jobCapacity * sizeof(CFGJob));
+      assert(jobs != NULL && "Ran out of virtual memory\n");
+    }
+
+    CFGJob *job = &jobs[numJobs++];
+    memset(job, 0, sizeof(CFGJob));
+    job->spec.data = cfgBegin;
+    job->spec.size = delimiter - cfgBegin;
+    job->name = name;
+    job->nameLength = nameLength;
+
+    if (delimiter == end) {
       break;
     }
+
+    const char *eol = memchr(delimiter, '\n', end - delimiter);
+    cfgBegin = eol != NULL ? eol + 1 : end;
+    name = delimiter;
+    nameLength = (eol != NULL ? eol : end) - delimiter;
   }
 
-  if (!found) {
-    tempSet[tempSetSize] = bbOffset;
-    tempSetSize++;
+  stats->parseTime += current_time_ms() - splitStart;
+
+  const CFGOptions *opts = &ctx->opts;
+
+  if (opts->numThreads > 1 && numJobs > 1 && opts->binaryOutput == NULL) {
+    analyse_cfg_batch_in_parallel(ctx, jobs, numJobs, stats);
+  } else {
+    for (int i=0 ; i<numJobs ; i++) {
+      analyse_cfg_job(ctx, &jobs[i], opts->numThreads, cacheMissCounter,
+                      stats);
+    }
   }
 
-  memcpy(n->doms, tempSet, tempSetSize * sizeof(PoolOffset));
-  n->numDoms = tempSetSize;
-  return oldNumDoms != tempSetSize;
+  free(jobs);
 }
 
-static void intersect_dom_sets(PoolOffset *dest, int *destSize,
-                             PoolOffset *src, int *srcSize) {  
-  // if dest is the full set, then just copy the src set
-  if (*destSize == 0) {
-    *destSize = *srcSize;
-    memcpy(dest, src, *srcSize * sizeof(PoolOffset));
-    // NOTE we don't need to check if src is full since we are calculating
-    // dest = intersect(dest, src)
-  } else if (*srcSize > 0) {
-    PoolOffset res[MAX_DOMINATORS];
-    int resSize = 0;
+/// Parses the CFG of job with numThreads threads and analyses it.
+static void analyse_cfg_job(CFGContext *ctx, CFGJob *job, int numThreads,
+                            int cacheMissCounter, CFGStats *stats) {
+  double parseStart = current_time_ms();
+  long long parseStartMisses = read_counter(cacheMissCounter);
 
-    for (int i=0 ; i<*destSize ; i++) {
-      for (int j=0 ; j<*srcSize ; j++) {
-        if (dest[i] == src[j]) {
-          res[resSize++] = dest[i];
-        }
-      }
+  parse_cfg_spec(ctx, &job->spec, numThreads);
+  finish_cfg(ctx, job->name, job->nameLength, cacheMissCounter, parseStart,
+             parseStartMisses, stats);
+}
+
+/// Makes the CFG in input, a text spec of a single CFG or a binary CFG,
+/// the current CFG of ctx. Text is parsed by ctx->opts.parser with
+/// numThreads threads. Binary CFGs are used in place, so input must be
+/// kept until the next CFG is parsed. Returns FALSE, leaving the CFG empty,
+/// if input is not a valid binary CFG or the strtok parser rejects it.
+static bool parse_cfg_spec(CFGContext *ctx, const InputBuffer *input,
+                           int numThreads) {
+  reset_graph(ctx);
+
+  if (cfg_binary_is_binary(input->data, input->size)) {
+    return map_cfg_binary(ctx, input);
+  }
+
+  // Arrays that outgrow the arena's blocks are copied and their old memory
+  // is wasted until the next CFG. Most lines of a spec hold a BB and at
+  // least one of its succs, so sizing the arrays by the number of lines
+  // saves most of the copies.
+  int numLines = count_spec_lines(input);
+  spec_table_reserve(&ctx->cfgSpec, numLines, numLines);
+
+  if (ctx->opts.parser == CFG_PARSER_STRTOK) {
+    FILE *in = fmemopen((void *)input->data, input->size, "r");
+    size_t inputSize;
+    assert(in != NULL && "Ran out of virtual memory\n");
+    bool ok = parse_cfg_with_strtok(in, &ctx->cfgSpec, &inputSize);
+    fclose(in);
+
+    if (!ok) {
+      reset_graph(ctx);
+      return FALSE;
+    }
+  } else {
+    parse_cfg_in_chunks(input, ctx->opts.parser, numThreads, &ctx->cfgSpec);
+  }
+
+  use_parsed_spec(ctx);
+  build_csr_graph(ctx);
+  return TRUE;
+}
+
+/// Analyses the CFGs of a batch on ctx->opts.numThreads worker threads
+/// while the calling thread prints their output to ctx->out in input order
+/// as soon as it is ready. Every worker analyses its CFGs in a CFGContext of
+/// its own, whose memory is reused from one CFG to the next.
+///
+/// To keep a large CFG from being analysed last while the other workers are
+/// idle, jobs are handed out largest first: they are sorted by the size of
+/// their spec and dealt round-robin to the workers' deques. A worker whose
+/// deque is empty steals from the tail of the others, where the smallest
+/// jobs are.
+static void analyse_cfg_batch_in_parallel(CFGContext *ctx, CFGJob *jobs,
+                                          int numJobs, CFGStats *stats) {
+  CFGWorkerPool pool;
+  int numThreads = ctx->opts.numThreads;
+  int numWorkers = numThreads < numJobs ? numThreads : numJobs;
+  int dequeCapacity = (numJobs + numWorkers - 1) / numWorkers;
+  int *bySize = malloc(numJobs * sizeof(int));
+  CFGWorker *workers = calloc(numWorkers, sizeof(CFGWorker));
+  pthread_t *threads = malloc(numWorkers * sizeof(pthread_t));
+
+  pool.opts = &ctx->opts;
+  pool.jobs = jobs;
+  pool.numJobs = numJobs;
+  pool.numWorkers = numWorkers;
+  pool.deques = calloc(numWorkers, sizeof(JobDeque));
+  assert(bySize != NULL && workers != NULL && threads != NULL
+         && pool.deques != NULL && "Ran out of virtual memory\n");
+  pthread_mutex_init(&pool.doneLock, NULL);
+  pthread_cond_init(&pool.doneCond, NULL);
+
+  // Sort by decreasing size, and by index among jobs of the same size, by
+  // packing both in one key.
+  uint64_t *keys = malloc(numJobs * sizeof(uint64_t));
+  assert(keys != NULL && "Ran out of virtual memory\n");
+  for (int i=0 ; i<numJobs ; i++) {
+    uint64_t size = jobs[i].spec.size < UINT32_MAX
+      ? jobs[i].spec.size : UINT32_MAX;
+    keys[i] = (UINT32_MAX - size) << 32 | (uint32_t)i;
+  }
+  qsort(keys, numJobs, sizeof(uint64_t), compare_u64);
+  for (int i=0 ; i<numJobs ; i++) {
+    bySize[i] = (int)(uint32_t)keys[i];
+  }
+  free(keys);
+
+  for (int w=0 ; w<numWorkers ; w++) {
+    JobDeque *deque = &pool.deques[w];
+    pthread_mutex_init(&deque->lock, NULL);
+    deque->jobs = malloc(dequeCapacity * sizeof(int));
+    assert(deque->jobs != NULL && "Ran out of virtual memory\n");
+  }
+
+  for (int i=0 ; i<numJobs ; i++) {
+    JobDeque *deque = &pool.deques[i % numWorkers];
+    deque->jobs[deque->tail++] = bySize[i];
+  }
+
+  for (int w=0 ; w<numWorkers ; w++) {
+    workers[w].pool = &pool;
+    workers[w].index = w;
+    int error = pthread_create(&threads[w], NULL, run_cfg_worker,
+                               &workers[w]);
+    assert(error == 0 && "Failed to start a worker thread\n");
+  }
+
+  for (int i=0 ; i<numJobs ; i++) {
+    pthread_mutex_lock(&pool.doneLock);
+    while (!jobs[i].done) {
+      pthread_cond_wait(&pool.doneCond, &pool.doneLock);
+    }
+    pthread_mutex_unlock(&pool.doneLock);
+
+    out_buffer_write(&ctx->out, jobs[i].output, jobs[i].outputSize);
+    free(jobs[i].output);
+    jobs[i].output = NULL;
+  }
+
+  for (int w=0 ; w<numWorkers ; w++) {
+    pthread_join(threads[w], NULL);
+
+    CFGStats *workerStats = &workers[w].stats;
+    stats->numCFGs += workerStats->numCFGs;
+    stats->numBBs += workerStats->numBBs;
+    stats->numEdges += workerStats->numEdges;
+    stats->parseTime += workerStats->parseTime;
+    stats->analysisTime += workerStats->analysisTime;
+    stats->parseMisses += workerStats->parseMisses;
+    stats->analysisMisses += workerStats->analysisMisses;
+    if (workerStats->peakGraphSize > stats->peakGraphSize) {
+      stats->peakGraphSize = workerStats->peakGraphSize;
+      stats->peakGraphBBs = workerStats->peakGraphBBs;
+    }
+    stats->arenaHighWater = max(stats->arenaHighWater,
+                                workerStats->arenaHighWater);
+    stats->arenaReserved = max(stats->arenaReserved,
+                               workerStats->arenaReserved);
+
+    pthread_mutex_destroy(&pool.deques[w].lock);
+    free(pool.deques[w].jobs);
+  }
+
+  pthread_mutex_destroy(&pool.doneLock);
+  pthread_cond_destroy(&pool.doneCond);
+  free(pool.deques);
+  free(bySize);
+  free(workers);
+  free(threads);
+}
+
+/// Thread entry point of a worker of a CFGWorkerPool. The output of each
+/// CFG is collected in the worker's OutBuffer and handed over to its job.
+static void *run_cfg_worker(void *arg) {
+  CFGWorker *worker = arg;
+  CFGWorkerPool *pool = worker->pool;
+  CFGContext *ctx = cfg_context_create(pool->opts);
+  int cacheMissCounter = pool->opts->printStats
+    ? open_cache_miss_counter() : -1;
+  int jobIndex;
+
+  out_buffer_set_sink(&ctx->out, -1, NULL);
+
+  while ((jobIndex = take_cfg_job(pool, worker->index)) != -1) {
+    CFGJob *job = &pool->jobs[jobIndex];
+
+    analyse_cfg_job(ctx, job, 1, cacheMissCounter, &worker->stats);
+    job->output = out_buffer_detach(&ctx->out, &job->outputSize);
+
+    pthread_mutex_lock(&pool->doneLock);
+    job->done = TRUE;
+    pthread_cond_broadcast(&pool->doneCond);
+    pthread_mutex_unlock(&pool->doneLock);
+  }
+
+  if (cacheMissCounter != -1) {
+    close(cacheMissCounter);
+  }
+
+  add_arena_stats(ctx, &worker->stats);
+  cfg_context_destroy(ctx);
+  return NULL;
+}
+
+/// Returns the next job for the worker at workerIndex, taken from its own
+/// deque or else stolen from another one, or -1 once all jobs are taken.
+/// No jobs are added once the workers run, so a worker that finds every
+/// deque empty is done.
+static int take_cfg_job(CFGWorkerPool *pool, int workerIndex) {
+  JobDeque *own = &pool->deques[workerIndex];
+  int job = -1;
+
+  pthread_mutex_lock(&own->lock);
+  if (own->head < own->tail) {
+    job = own->jobs[own->head++];
+  }
+  pthread_mutex_unlock(&own->lock);
+
+  for (int i=1 ; job == -1 && i<pool->numWorkers ; i++) {
+    JobDeque *victim = &pool->deques[(workerIndex + i) % pool->numWorkers];
+
+    pthread_mutex_lock(&victim->lock);
+    if (victim->head < victim->tail) {
+      job = victim->jobs[--victim->tail];
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+
+  return job;
+}
+
+/// Returns the number of lines of input, counting a last line without a
+/// newline.
+static int count_spec_lines(const InputBuffer *input) {
+  const char *p = input->data;
+  const char *end = input->data + input->size;
+  int numLines = 0;
+
+  while ((p = memchr(p, '\n', end - p)) != NULL) {
+    numLines++;
+    p++;
+  }
+
+  return numLines + (input->size > 0 && end[-1] != '\n');
+}
+
+/// Returns the first '@' in [p, end) that is preceded by nothing but blanks
+/// on its line, or end if there is none. begin is the start of the input.
+static const char *find_cfg_delimiter(const char *begin, const char *p,
+                                      const char *end) {
+  while ((p = memchr(p, '@', end - p)) != NULL) {
+    const char *lineStart = p;
+
+    while (lineStart > begin
+           && (lineStart[-1] == ' ' || lineStart[-1] == '\t')) {
+      lineStart--;
     }
 
-    *destSize = resSize;
-    memcpy(dest, res, resSize * sizeof(PoolOffset)); 
+    if (lineStart == begin || lineStart[-1] == '\n') {
+      return p;
+    }
+
+    p++;
   }
+
+  return end;
 }
 
-// pot is the post-order traversal index of the current node
-// rpot is a int -> PoolOffset map that specifies the reverse post order
-// traversal of the CFG
-static void calculate_reverse_post_order(PoolOffset bbOffset, int *pot,
-                                      int *rpot, bool *visited) {
-  assert(bbOffset < currentNumCFGNodes && "Invalid BB");
+/// Analyses and prints the CFG that was just parsed, or converts it if
+/// ctx->opts.binaryOutput is set, and adds it to stats. name is the CFG's
+/// delimiter line, or NULL if it has none. Parsing started at
+/// parseStart.
+static void finish_cfg(CFGContext *ctx, const char *name, int nameLength,
+                       int cacheMissCounter, double parseStart,
+                       long long parseStartMisses, CFGStats *stats) {
+  double parseEnd = current_time_ms();
+  long long parseEndMisses = read_counter(cacheMissCounter);
+
+  stats->parseTime += parseEnd - parseStart;
+  stats->parseMisses += parseEndMisses - parseStartMisses;
 
-  if (visited[bbOffset]) {
+  if (name == NULL && ctx->currentNumCFGNodes == 0) {
     return;
   }
 
-  CFGNodePtr bb = cfgNodePool + bbOffset;
-  visited[bbOffset] = TRUE;
-  for (int i=0 ; i<bb->numSuccs ; i++) {
-    calculate_reverse_post_order(bb->succs[i], pot, rpot, visited);
+  if (ctx->opts.binaryOutput == NULL) {
+    calculate_dominance(ctx);
+    print_analysis(ctx, name, nameLength);
+  } else if (stats->numCFGs == 0) {
+    write_cfg_binary(ctx, ctx->opts.binaryOutput);
+  } else if (stats->numCFGs == 1) {
+    fprintf(stderr, "The binary format holds a single CFG, only the first "
+            "one is converted\n");
+  }
+
+  size_t graphSize = graph_memory_size(ctx);
+  if (graphSize > stats->peakGraphSize) {
+    stats->peakGraphSize = graphSize;
+    stats->peakGraphBBs = ctx->currentNumCFGNodes;
+  }
+
+  stats->numCFGs++;
+  stats->numBBs += ctx->currentNumCFGNodes;
+  stats->numEdges += ctx->numParsedEdges;
+  stats->analysisTime += current_time_ms() - parseEnd;
+  stats->analysisMisses += read_counter(cacheMissCounter) - parseEndMisses;
+}
+
+/// Records the arena memory of ctx in stats if it needed more than the
+/// arenas recorded so far.
+static void add_arena_stats(const CFGContext *ctx, CFGStats *stats) {
+  ArenaStats arenaStats;
+
+  arena_stats(&ctx->arena, &arenaStats);
+  stats->arenaHighWater = max(stats->arenaHighWater, arenaStats.highWater);
+  stats->arenaReserved = max(stats->arenaReserved, arenaStats.reserved);
+}
+
+/// Parses the CFG spec line by line with fgets and strtok_r, whose state
+/// lives in the call (unlike strtok's) so that contexts on different
+/// threads can use this parser at the same time.
+///
+/// This is the original parser, kept as a reference for the faster ones.
+/// Lines longer than MAX_SPEC_LINE_LEN are split and their tails parsed as
+/// if they were separate lines. The whole spec is one CFG, so delimiter
+/// lines are rejected rather than read as BB 0, and so are binary CFGs.
+/// Stores the number of bytes read in inputSize. Returns FALSE, after
+/// printing the reason to stderr, if the spec is rejected.
+static bool parse_cfg_with_strtok(FILE *in, SpecTable *table,
+                                  size_t *inputSize) {
+  char cfgSpecLine[MAX_SPEC_LINE_LEN];
+
+  *inputSize = 0;
+
+  while (fgets(cfgSpecLine, MAX_SPEC_LINE_LEN, in) != NULL) {
+    char *save;
+
+    if (*inputSize == 0
+        && strncmp(cfgSpecLine, CFG_BINARY_MAGIC, 8) == 0) {
+      fprintf(stderr, "The strtok parser does not read binary CFGs\n");
+      return FALSE;
+    }
+
+    *inputSize += strlen(cfgSpecLine);
+    char *tok = strtok_r(cfgSpecLine, " \n\t:", &save);
+
+    if (tok == NULL || *tok == '!') {
+      continue;
+    }
+
+    if (*tok == '@') {
+      fprintf(stderr, "The strtok parser reads a single CFG, without "
+              "'@' delimiter lines\n");
+      return FALSE;
+    }
+
+    BBID srcBBID = strtol(tok, NULL, 10);
+    PoolOffset srcBBOffset = spec_table_intern(table, srcBBID);
+
+    while ((tok = strtok_r(NULL, " \n\t,", &save)) != NULL) {
+      BBID destBBID = strtol(tok, NULL, 10);
+      PoolOffset destBBOffset = spec_table_intern(table, destBBID);
+      spec_table_add_edge(table, srcBBOffset, destBBOffset);
+    }
   }
 
-  rpot[currentNumCFGNodes-1-*pot] = bbOffset;
-  ++*pot;
+  return TRUE;
 }
 
-/// Search for the CFGNode correspomding to the passed bbID and if found
-/// return it. Otherwise, take a new node from the pool and assign it to
-/// the BB.
-static PoolOffset get_cfg_node_for_bb(BBID bbID) {
-  for (int i=0 ; i<currentNumCFGNodes ; i++) {
-    if (cfgNodePool[i].id == bbID) {
-      return i;
+/// Parses the whole input in place (see load_input) with the scan or simd
+/// parser into table. With more than one thread, the input is split at line
+/// boundaries into one chunk per thread and each chunk is parsed into a
+/// table of its own. The chunk tables are then merged in input order, which
+/// numbers BBs and orders edges exactly as parsing the whole input in one
+/// go would.
+static void parse_cfg_in_chunks(const InputBuffer *input, CFGParser parser,
+                                int numThreads, SpecTable *table) {
+  numThreads = max(1, numThreads);
+  if ((size_t)numThreads > input->size / MIN_PARSE_CHUNK) {
+    numThreads = max(1, (int)(input->size / MIN_PARSE_CHUNK));
+  }
+
+  SpecChunk *chunks = calloc(numThreads, sizeof(SpecChunk));
+  pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+  assert(chunks != NULL && threads != NULL
+         && "Ran out of virtual memory\n");
+
+  const char *end = input->data + input->size;
+  const char *chunkBegin = input->data;
+
+  for (int i=0 ; i<numThreads ; i++) {
+    const char *chunkEnd = end;
+
+    if (i < numThreads-1) {
+      chunkEnd = input->data + input->size / numThreads * (i+1);
+      chunkEnd = max(chunkEnd, chunkBegin);
+      const char *eol = memchr(chunkEnd, '\n', end - chunkEnd);
+      chunkEnd = eol != NULL ? eol + 1 : end;
     }
+
+    chunks[i].begin = chunkBegin;
+    chunks[i].end = chunkEnd;
+    chunks[i].parser = parser;
+    chunkBegin = chunkEnd;
   }
 
-  // The pool is full, double its size.
-  if (currentNumCFGNodes == currentPoolSize) {
-    currentPoolSize = max(1, currentPoolSize*2);
-    cfgNodePool = realloc(cfgNodePool,
-                          currentPoolSize*sizeof(CFGNode));
-    assert(cfgNodePool != NULL && "Ran out of virtual memory\n");
+  // The first chunk is parsed by the calling thread, straight into table.
+  for (int i=1 ; i<numThreads ; i++) {
+    int error = pthread_create(&threads[i], NULL, parse_spec_chunk,
+                               &chunks[i]);
+    assert(error == 0 && "Failed to start a parser thread\n");
+  }
+
+  chunks[0].table = *table;
+  parse_spec_chunk(&chunks[0]);
+  *table = chunks[0].table;
+
+  for (int i=1 ; i<numThreads ; i++) {
+    pthread_join(threads[i], NULL);
+    spec_table_merge(table, &chunks[i].table);
+  }
+
+  free(chunks);
+  free(threads);
+}
+
+/// Thread entry point parsing one SpecChunk.
+static void *parse_spec_chunk(void *arg) {
+  SpecChunk *chunk = arg;
+
+  if (chunk->parser == CFG_PARSER_SIMD) {
+    scan_spec_simd(chunk->begin, chunk->end - chunk->begin, &chunk->table);
+  } else {
+    scan_spec(chunk->begin, chunk->end, &chunk->table);
   }
 
-  assert(currentNumCFGNodes < currentPoolSize
-         && "Exceeded pool allocated size\n");
-  cfgNodePool[currentNumCFGNodes].id = bbID;
-  cfgNodePool[currentNumCFGNodes].numSuccs = 0;
-  cfgNodePool[currentNumCFGNodes].numPreds = 0;
-  currentNumCFGNodes++;
-  return currentNumCFGNodes - 1;
+  return NULL;
 }
 
-static void release_memory(CFGNodePtr bb) {
-  if (bb != NULL) {
-    for (int i=0 ; i<bb->numSuccs ; i++) {
-      release_memory(cfgNodePool + bb->succs[i]);
+/// Parses the CFG spec directly from the bytes of the input, without
+/// copying lines or tokens and without any limit on the line length.
+///
+/// The grammar is the one accepted by the strtok parser: the first integer
+/// on a line is the source BB and all following integers (separated by any
+/// mix of ',', ':' and blanks) are its successors. A '!' starts a comment
+/// that runs to the end of the line.
+static void scan_spec(const char *p, const char *end, SpecTable *table) {
+  PoolOffset srcBBOffset = UNDEFINED;
+
+  while (p < end) {
+    char c = *p;
+
+    if (c == '\n') {
+      srcBBOffset = UNDEFINED;
+      p++;
+    } else if (c == '!') {
+      const char *eol = memchr(p, '\n', end - p);
+      p = eol != NULL ? eol : end;
+    } else if ((c >= '0' && c <= '9') || c == '-') {
+      BBID bbID;
+      p = scan_bb_id(p, end, &bbID);
+      add_spec_bb(table, bbID, &srcBBOffset);
+    } else {
+      // Separators and blanks
+      p++;
     }
   }
 }
 
-static void print_cfg_node(PoolOffset bbOffset) {
-  CFGNodePtr n = cfgNodePool + bbOffset;
-  log("==================\n");
-  log("BBID: %d\n", n->id);
+/// Parses the same grammar as scan_spec but classifies the input
+/// SPEC_BLOCK_SIZE bytes at a time with spec_classify_block and only stops
+/// at the bytes that matter: newlines, comment starts and the first byte of
+/// each run of ID characters.
+static void scan_spec_simd(const char *data, size_t size, SpecTable *table) {
+  const char *end = data + size;
+  PoolOffset srcBBOffset = UNDEFINED;
+  // Whether the last byte of the previous block is an ID character, in
+  // which case a run at the start of this block is the tail of an ID that
+  // was already parsed.
+  uint64_t prevIDChar = 0;
+  bool inComment = FALSE;
+  char lastBlock[SPEC_BLOCK_SIZE];
+
+  for (size_t pos=0 ; pos<size ; pos+=SPEC_BLOCK_SIZE) {
+    const char *block = data + pos;
+    SpecBlockMasks masks;
+
+    // The last block is padded with blanks rather than read past the end
+    // of the input.
+    if (size - pos < SPEC_BLOCK_SIZE) {
+      memset(lastBlock, ' ', SPEC_BLOCK_SIZE);
+      memcpy(lastBlock, block, size - pos);
+      spec_classify_block(lastBlock, &masks);
+    } else {
+      spec_classify_block(block, &masks);
+    }
+
+    uint64_t runStarts = masks.idChars & ~(masks.idChars << 1 | prevIDChar);
+    uint64_t events = runStarts | masks.newlines | masks.comments;
+    prevIDChar = masks.idChars >> 63;
+
+    if (inComment) {
+      if (masks.newlines == 0) {
+        continue;
+      }
+
+      // Drop everything up to the newline that ends the comment.
+      events &= -(masks.newlines & -masks.newlines);
+      inComment = FALSE;
+    }
+
+    while (events != 0) {
+      uint64_t event = events & -events;
+      int i = __builtin_ctzll(events);
+
+      if (masks.newlines & event) {
+        srcBBOffset = UNDEFINED;
+      } else if (masks.comments & event) {
+        // Newlines after the comment start (event << 1 is 0 for the last
+        // byte of the block).
+        uint64_t newlines = masks.newlines & -(event << 1);
 
-  log("# Preds: %d [", n->numPreds);
-  for (int i=0 ; i<n->numPreds ; i++) {
-    log("%d", cfgNodePool[n->preds[i]].id);
-    log(i<(n->numPreds-1) ? ", " : "");
+        if (newlines == 0) {
+          inComment = TRUE;
+          break;
+        }
+
+        events &= -(newlines & -newlines);
+        continue;
+      } else {
+        // The run either ends in this block, where its length is the
+        // number of ID characters from i on, or it may go on in the next
+        // block and is followed to its end by add_spec_id_run.
+        uint64_t rest = ~(masks.idChars >> i) & (~(uint64_t)0 >> i);
+        int runLength = rest != 0 ? __builtin_ctzll(rest) : -1;
+        bool hasMinus = runLength == -1
+          || ((masks.minuses >> i) & (rest ^ (rest - 1))) != 0;
+        add_spec_id_run(table, block + i, end, runLength, hasMinus,
+                        &srcBBOffset);
+      }
+
+      events &= events - 1;
+    }
   }
-  log("]\n");
+}
 
-  log("# Succs: %d [", n->numSuccs);
-  for (int i=0 ; i<n->numSuccs ; i++) {
-    log("%d", cfgNodePool[n->succs[i]].id);
-    log(i<(n->numSuccs-1) ? ", " : "");
+/// Adds the BBs of the run of ID characters starting at p. If runLength is
+/// known (not -1) and the run holds digits only, its ID is converted without
+/// a loop over its digits; otherwise the run is split into IDs exactly as
+/// scan_spec would split it.
+static void add_spec_id_run(SpecTable *table, const char *p, const char *end,
+                            int runLength, bool hasMinus,
+                            PoolOffset *srcBBOffset) {
+  if (!hasMinus && runLength <= 8 && end - p >= 8) {
+    add_spec_bb(table, (BBID)spec_parse_digits(p, runLength), srcBBOffset);
+    return;
   }
-  log("]\n");
 
-  log("# Doms: %d [", n->numDoms);
-  for (int i=0 ; i<n->numDoms ; i++) {
-    log("%d", cfgNodePool[n->doms[i]].id);
-    log(i<(n->numDoms-1) ? ", " : "");
+  if (!hasMinus && runLength <= 16 && end - p >= 16) {
+    // IDs of up to 16 digits fit in 64 bits; truncating the value wraps it
+    // the same way scan_bb_id does.
+    uint64_t value = (uint64_t)spec_parse_digits(p, runLength - 8) * 100000000
+      + spec_parse_digits(p + runLength - 8, 8);
+    add_spec_bb(table, (BBID)(unsigned)value, srcBBOffset);
+    return;
   }
-  log("]\n");
 
-  log("------------------\n");
+  while (p < end && ((*p >= '0' && *p <= '9') || *p == '-')) {
+    BBID bbID;
+    p = scan_bb_id(p, end, &bbID);
+    add_spec_bb(table, bbID, srcBBOffset);
+  }
 }
 
-static void print_dom_set(char* setName, PoolOffset* set, int setSize) {
-  log("\t%s: [", setName);
-  if (setSize == 0) {
-    log("FULL SET");
+/// Adds a BB parsed from the spec: the first one of a line is the source
+/// BB of the line and each later one is a successor of it.
+static inline void add_spec_bb(SpecTable *table, BBID bbID,
+                               PoolOffset *srcBBOffset) {
+  PoolOffset bbOffset = spec_table_intern(table, bbID);
+
+  if (*srcBBOffset == UNDEFINED) {
+    *srcBBOffset = bbOffset;
   } else {
-    for (int i=0 ; i<setSize ; i++) {
-      log("%d", cfgNodePool[set[i]].id);
-      log(i<(setSize)-1 ? ", " : "");
+    spec_table_add_edge(table, *srcBBOffset, bbOffset);
+  }
+}
+
+/// Converts the decimal integer starting at p (a digit or a '-') and
+/// returns a pointer past its last digit. As with strtol, a lone '-'
+/// converts to 0.
+static const char *scan_bb_id(const char *p, const char *end, BBID *bbID) {
+  bool negative = *p == '-';
+  unsigned value = 0;
+
+  if (negative) {
+    p++;
+  }
+
+  while (p < end && (unsigned)(*p - '0') < 10) {
+    value = value * 10 + (*p - '0');
+    p++;
+  }
+
+  *bbID = negative ? -(BBID)value : (BBID)value;
+  return p;
+}
+
+/// Points the CSR arrays and the BBIDs of the pool into the binary CFG in
+/// input, which must be kept until the next CFG is parsed. Returns FALSE,
+/// leaving the CFG empty, if input is not a valid binary CFG.
+static bool map_cfg_binary(CFGContext *ctx, const InputBuffer *input) {
+  CFGBinaryView view;
+  const char *error = cfg_binary_view(input->data, input->size, &view);
+
+  if (error != NULL) {
+    fprintf(stderr, "Invalid binary CFG: %s\n", error);
+    return FALSE;
+  }
+
+  // Unlike text, the arrays are read in no particular order.
+  if (input->mapped) {
+    madvise((void *)input->data, input->size, MADV_WILLNEED);
+  }
+
+  ctx->graphInput = *input;
+  ctx->currentNumCFGNodes = view.numBBs;
+  ctx->currentPoolSize = view.numBBs;
+  ctx->numParsedEdges = view.numEdges;
+  ctx->succOffsets = (int *)view.succOffsets;
+  ctx->succs = (PoolOffset *)view.succs;
+  ctx->predOffsets = (int *)view.predOffsets;
+  ctx->preds = (PoolOffset *)view.preds;
+
+  if (view.ids != NULL) {
+    ctx->cfgNodePool.ids = (BBID *)view.ids;
+  } else {
+    // BBIDs default to the BBs' offsets.
+    for (int i=0 ; i<view.numBBs ; i++) {
+      spec_table_intern(&ctx->cfgSpec, i);
+    }
+    ctx->cfgNodePool.ids = ctx->cfgSpec.ids;
+  }
+
+  return TRUE;
+}
+
+/// Writes the current CFG to out in the binary format. BBIDs are left out
+/// if every BB's ID is its offset in the pool.
+static void write_cfg_binary(CFGContext *ctx, FILE *out) {
+  CFGBinaryView view;
+  bool needIDs = FALSE;
+
+  for (int i=0 ; i<ctx->currentNumCFGNodes ; i++) {
+    if (ctx->cfgNodePool.ids[i] != i) {
+      needIDs = TRUE;
+      break;
+    }
+  }
+
+  view.numBBs = ctx->currentNumCFGNodes;
+  view.numEdges = ctx->numParsedEdges;
+  view.succOffsets = ctx->succOffsets;
+  view.succs = ctx->succs;
+  view.predOffsets = ctx->predOffsets;
+  view.preds = ctx->preds;
+  view.ids = needIDs ? ctx->cfgNodePool.ids : NULL;
+
+  if (!cfg_binary_write(out, &view)) {
+    perror("Failed to write the binary CFG");
+  }
+}
+
+/// Makes the whole content of in available as one block of memory. Regular
+/// files are mapped into memory, anything else is read through a growing
+/// heap buffer. Returns FALSE, after printing the reason to stderr and
+/// leaving input empty, if in cannot be read.
+static bool load_input(FILE *in, InputBuffer *input) {
+  int fd = fileno(in);
+  struct stat st;
+
+  input->data = NULL;
+  input->size = 0;
+  input->mapped = FALSE;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+      && ftell(in) == 0) {
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data != MAP_FAILED) {
+      madvise(data, st.st_size, MADV_SEQUENTIAL);
+      input->data = data;
+      input->size = st.st_size;
+      input->mapped = TRUE;
+      return TRUE;
+    }
+  }
+
+  char *buffer = NULL;
+  size_t capacity = 0;
+  size_t numRead;
+
+  do {
+    if (capacity - input->size < INPUT_READ_CHUNK) {
+      capacity = max(2 * capacity, input->size + INPUT_READ_CHUNK);
+      buffer = realloc(buffer, capacity);
+      assert(buffer != NULL && "Ran out of virtual memory\n");
+    }
+
+    numRead = fread(buffer + input->size, 1, INPUT_READ_CHUNK, in);
+    input->size += numRead;
+  } while (numRead > 0);
+
+  if (ferror(in)) {
+    perror("Failed to read the input");
+    free(buffer);
+    input->size = 0;
+    return FALSE;
+  }
+
+  input->data = buffer;
+  return TRUE;
+}
+
+static void release_input(InputBuffer *input) {
+  if (input->mapped) {
+    munmap((void *)input->data, input->size);
+  } else {
+    free((void *)input->data);
+  }
+}
+
+/// Calculate dominance information using the engine selected in ctx.
+static void calculate_dominance(CFGContext *ctx) {
+  if (ctx->currentNumCFGNodes == 0) {
+    return;
+  }
+
+  init_dom_graph(ctx);
+  allocate_analysis_arrays(ctx);
+  calculate_dfs_orders(ctx);
+
+  for (int i=0 ; i<ctx->domGraph.numNodes ; i++) {
+    ctx->cfgNodePool.idoms[i] = UNDEFINED;
+  }
+
+  DominanceEngine engine = ctx->opts.engine;
+
+  // Full dominator sets are cheap to compute for tiny CFGs but cost
+  // quadratic time and memory for larger ones.
+  if (engine == DOM_ENGINE_AUTO) {
+    engine = ctx->currentNumCFGNodes < ctx->opts.autoEngineThreshold
+      ? DOM_ENGINE_ITERATIVE : DOM_ENGINE_SEMI_NCA;
+  }
+
+  switch (engine) {
+  case DOM_ENGINE_AUTO:
+    assert(FALSE && "Dominance engine not resolved");
+    break;
+  case DOM_ENGINE_ITERATIVE:
+    calculate_dominance_iterative(ctx, ctx->rpot, ctx->numReachableCFGNodes);
+    break;
+  case DOM_ENGINE_CHK:
+    calculate_dominance_chk(ctx, ctx->rpot, ctx->numReachableCFGNodes);
+    break;
+  case DOM_ENGINE_LT:
+    calculate_dominance_lt(ctx, FALSE);
+    break;
+  case DOM_ENGINE_LT_BALANCED:
+    calculate_dominance_lt(ctx, TRUE);
+    break;
+  case DOM_ENGINE_SEMI_NCA:
+    calculate_dominance_semi_nca(ctx);
+    break;
+  }
+
+  if (ctx->domGraph.virtualExit != UNDEFINED) {
+    remove_virtual_exit(ctx);
+  }
+}
+
+/// Points ctx->domGraph at the CSR arrays of the CFG, or of its reverse if
+/// ctx->opts.postDominators is set. Only the list of the exits of the CFG
+/// is allocated for the reverse graph.
+static void init_dom_graph(CFGContext *ctx) {
+  DomGraph *graph = &ctx->domGraph;
+  int n = ctx->currentNumCFGNodes;
+
+  if (!ctx->opts.postDominators) {
+    graph->succOffsets = ctx->succOffsets;
+    graph->succs = ctx->succs;
+    graph->predOffsets = ctx->predOffsets;
+    graph->preds = ctx->preds;
+    graph->entry = 0;
+    graph->numNodes = n;
+    graph->virtualExit = UNDEFINED;
+    graph->exits = NULL;
+    graph->numExits = 0;
+    return;
+  }
+
+  graph->succOffsets = ctx->predOffsets;
+  graph->succs = ctx->preds;
+  graph->predOffsets = ctx->succOffsets;
+  graph->preds = ctx->succs;
+  graph->entry = n;
+  graph->numNodes = n + 1;
+  graph->virtualExit = n;
+  graph->numExits = 0;
+
+  for (PoolOffset bb=0 ; bb<n ; bb++) {
+    graph->numExits += ctx->succOffsets[bb] == ctx->succOffsets[bb+1];
+  }
+
+  graph->exits = arena_alloc(&ctx->arena, graph->numExits
+                             * sizeof(PoolOffset));
+  graph->numExits = 0;
+  for (PoolOffset bb=0 ; bb<n ; bb++) {
+    if (ctx->succOffsets[bb] == ctx->succOffsets[bb+1]) {
+      graph->exits[graph->numExits++] = bb;
+    }
+  }
+}
+
+/// Drops the virtual exit from the results of the analysis of the reverse
+/// CFG, so that they describe the BBs alone: the BBs whose IPDOM is the
+/// virtual exit become roots of a post-dominator forest, each its own
+/// IPDOM, and the traversal orders start with the BBs after the virtual
+/// exit, which came first in both.
+static void remove_virtual_exit(CFGContext *ctx) {
+  CFGNodePool *pool = &ctx->cfgNodePool;
+  PoolOffset virtualExit = ctx->domGraph.virtualExit;
+  int numReachable = ctx->numReachableCFGNodes - 1;
+
+  memmove(ctx->preorder, ctx->preorder + 1,
+          numReachable * sizeof(PoolOffset));
+  memmove(ctx->rpot, ctx->rpot + 1, numReachable * sizeof(PoolOffset));
+  ctx->numReachableCFGNodes = numReachable;
+
+  for (int i=0 ; i<numReachable ; i++) {
+    PoolOffset bb = ctx->preorder[i];
+
+    pool->preNumbers[bb]--;
+    pool->rpoNumbers[bb]--;
+    if (pool->idoms[bb] == virtualExit) {
+      pool->idoms[bb] = bb;
+    }
+    if (pool->dfsParents[bb] == virtualExit) {
+      pool->dfsParents[bb] = UNDEFINED;
+    }
+  }
+}
+
+/// Allocates the per-BB arrays of the pool that are filled by the analysis
+/// as well as the traversal orders, unless the current CFG already has
+/// them.
+static void allocate_analysis_arrays(CFGContext *ctx) {
+  int n = ctx->domGraph.numNodes;
+  CFGNodePool *pool = &ctx->cfgNodePool;
+
+  if (pool->idoms != NULL) {
+    return;
+  }
+
+  pool->idoms = arena_alloc(&ctx->arena, n * sizeof(PoolOffset));
+  pool->preNumbers = arena_alloc(&ctx->arena, n * sizeof(int));
+  pool->postNumbers = arena_alloc(&ctx->arena, n * sizeof(int));
+  pool->rpoNumbers = arena_alloc(&ctx->arena, n * sizeof(int));
+  pool->dfsParents = arena_alloc(&ctx->arena, n * sizeof(PoolOffset));
+  ctx->preorder = arena_alloc(&ctx->arena, n * sizeof(PoolOffset));
+  ctx->rpot = arena_alloc(&ctx->arena, n * sizeof(PoolOffset));
+}
+
+/// Traverses the CFG depth-first from the entry BB and records, in a single
+/// pass, the preorder, postorder and reverse-post-order numbers of all
+/// reachable BBs, their DFS tree parents and the preorder and RPO sequences
+/// themselves.
+///
+/// Successors are visited in the order they appear in the input. An
+/// explicit stack is used instead of recursion since CFGs produced by code
+/// generators can be hundreds of thousands of BBs deep.
+static void calculate_dfs_orders(CFGContext *ctx) {
+  const DomGraph *graph = &ctx->domGraph;
+  int n = graph->numNodes;
+  int *preNumbers = ctx->cfgNodePool.preNumbers;
+  int *postNumbers = ctx->cfgNodePool.postNumbers;
+  PoolOffset *dfsParents = ctx->cfgNodePool.dfsParents;
+  PoolOffset *stack = arena_alloc(&ctx->arena, n * sizeof(PoolOffset));
+
+  for (int i=0 ; i<n ; i++) {
+    preNumbers[i] = UNDEFINED;
+    postNumbers[i] = UNDEFINED;
+    ctx->cfgNodePool.rpoNumbers[i] = UNDEFINED;
+    dfsParents[i] = UNDEFINED;
+  }
+
+  // While a BB is on the stack, its postNumbers slot holds the index among
+  // its succs of the next one to visit. It gets the BB's actual postorder
+  // number once the BB is popped.
+  int top = 0;
+  int numPre = 0;
+  int numPost = 0;
+
+  preNumbers[graph->entry] = numPre;
+  ctx->preorder[numPre++] = graph->entry;
+  postNumbers[graph->entry] = 0;
+  stack[top++] = graph->entry;
+
+  while (top > 0) {
+    PoolOffset bb = stack[top-1];
+    int numSuccs;
+    const PoolOffset *succs = dom_graph_succs(graph, bb, &numSuccs);
+
+    if (postNumbers[bb] == numSuccs) {
+      top--;
+      postNumbers[bb] = numPost++;
+      continue;
+    }
+
+    PoolOffset succ = succs[postNumbers[bb]++];
+    if (preNumbers[succ] == UNDEFINED) {
+      preNumbers[succ] = numPre;
+      ctx->preorder[numPre++] = succ;
+      dfsParents[succ] = bb;
+      postNumbers[succ] = 0;
+      stack[top++] = succ;
+    }
+  }
+
+  ctx->numReachableCFGNodes = numPre;
+  for (int i=0 ; i<numPre ; i++) {
+    PoolOffset bb = ctx->preorder[i];
+    int rpoNumber = numPre - 1 - postNumbers[bb];
+    ctx->cfgNodePool.rpoNumbers[bb] = rpoNumber;
+    ctx->rpot[rpoNumber] = bb;
+  }
+}
+
+/// Calculate dominance information as described in Section 9.2.1 of
+/// "Engineering a compiler", 2011
+///
+/// The dominator set of every BB is a bitset over PoolOffsets and all sets
+/// are stored back to back in a single allocation.
+static void calculate_dominance_iterative(CFGContext *ctx, int *rpot,
+                                          int numReachable) {
+  int n = ctx->domGraph.numNodes;
+  PoolOffset entry = ctx->domGraph.entry;
+  size_t numWords = bitset_num_words(n);
+  BitsetWord *domSets = arena_alloc(&ctx->arena, (n + 1) * numWords
+                                    * sizeof(BitsetWord));
+  BitsetWord *tempSet = domSets + n * numWords;
+
+  // The entry node only dominates itself while all other BBs start out
+  // dominated by every BB in the CFG. The sets then shrink to a fixed
+  // point.
+  for (int i=0 ; i<n ; i++) {
+    bitset_fill(domSets + i * numWords, n);
+  }
+
+  memset(domSets + entry * numWords, 0, numWords * sizeof(BitsetWord));
+  bitset_set(domSets + entry * numWords, entry);
+
+  bool changed = TRUE;
+
+  while(changed) {
+    changed = FALSE;
+
+    // Update the dom sets of BB's according to their reverse-post-order
+    // traversal.
+    for (int i=1 ; i<numReachable ; i++) {
+      changed |= update_dom_set(ctx, rpot[i], domSets, tempSet, numWords);
+    }
+  }
+
+  // The dominators of a BB form a chain in the dominator tree, so the depth
+  // of a BB is the size of its dom set minus one and its immediate
+  // dominator is the one dominator exactly one level above it.
+  int *depth = arena_alloc(&ctx->arena, n * sizeof(int));
+
+  for (int i=0 ; i<numReachable ; i++) {
+    PoolOffset bb = rpot[i];
+    depth[bb] = bitset_count(domSets + bb * numWords, numWords) - 1;
+  }
+
+  ctx->cfgNodePool.idoms[entry] = entry;
+  for (int i=1 ; i<numReachable ; i++) {
+    PoolOffset bb = rpot[i];
+    BitsetWord *doms = domSets + bb * numWords;
+
+    for (size_t w=0 ; w<numWords ; w++) {
+      for (BitsetWord bits=doms[w] ; bits != 0 ; bits &= bits - 1) {
+        PoolOffset d = w * BITSET_WORD_BITS + __builtin_ctzll(bits);
+
+        if (depth[d] == depth[bb] - 1) {
+          ctx->cfgNodePool.idoms[bb] = d;
+        }
+      }
+    }
+  }
+}
+
+/// Calculate the immediate dominators of the BBs as described in "A Simple,
+/// Fast Dominance Algorithm", Cooper, Harvey and Kennedy, 2001.
+///
+/// Only the idom of each BB is computed; the full dominator sets are
+/// derived on demand by get_dom_set.
+static void calculate_dominance_chk(CFGContext *ctx, int *rpot,
+                                    int numReachable) {
+  PoolOffset entry = ctx->domGraph.entry;
+
+  ctx->cfgNodePool.idoms[entry] = entry;
+
+  bool changed = TRUE;
+
+  while (changed) {
+    changed = FALSE;
+
+    for (int i=1 ; i<numReachable ; i++) {
+      PoolOffset bb = rpot[i];
+      PoolOffset newIdom = UNDEFINED;
+      int numPreds;
+      const PoolOffset *preds = dom_graph_preds(&ctx->domGraph, bb,
+                                                &numPreds);
+
+      // Preds that were not processed yet (i.e. reached through back
+      // edges) are ignored until a later iteration.
+      for (int j=0 ; j<numPreds ; j++) {
+        PoolOffset pred = preds[j];
+
+        if (ctx->cfgNodePool.idoms[pred] == UNDEFINED) {
+          continue;
+        }
+
+        newIdom = newIdom == UNDEFINED
+          ? pred : intersect_idoms(ctx, pred, newIdom);
+      }
+
+      if (ctx->cfgNodePool.idoms[bb] != newIdom) {
+        ctx->cfgNodePool.idoms[bb] = newIdom;
+        changed = TRUE;
+      }
+    }
+  }
+}
+
+/// Walks up the (partially built) dominator tree from b1 and b2 until both
+/// "fingers" meet at their nearest common dominator. BBs deeper in the tree
+/// have larger reverse-post-order numbers.
+static PoolOffset intersect_idoms(CFGContext *ctx, PoolOffset b1,
+                                  PoolOffset b2) {
+  PoolOffset *idoms = ctx->cfgNodePool.idoms;
+  int *rpoNumbers = ctx->cfgNodePool.rpoNumbers;
+
+  while (b1 != b2) {
+    while (rpoNumbers[b1] > rpoNumbers[b2]) {
+      b1 = idoms[b1];
+    }
+
+    while (rpoNumbers[b2] > rpoNumbers[b1]) {
+      b2 = idoms[b2];
+    }
+  }
+
+  return b1;
+}
+
+/// Calculate the immediate dominators of the BBs as described in "A Fast
+/// Algorithm for Finding Dominators in a Flowgraph", Lengauer and Tarjan,
+/// 1979.
+///
+/// If balanced is FALSE, the simple version of LINK and EVAL (path
+/// compression only) is used which runs in O(m log n). Otherwise, the
+/// sophisticated version that also keeps the trees of the forest balanced
+/// is used which runs in O(m alpha(m, n)).
+static void calculate_dominance_lt(CFGContext *ctx, bool balanced) {
+  int n = ctx->domGraph.numNodes;
+  LTState s;
+  int *mem = arena_alloc(&ctx->arena, 11 * (n + 1) * sizeof(int));
+  memset(mem, 0, 11 * (n + 1) * sizeof(int));
+
+  s.vertex = mem;
+  s.parent = mem + (n + 1);
+  s.semi = mem + 2 * (n + 1);
+  s.label = mem + 3 * (n + 1);
+  s.ancestor = mem + 4 * (n + 1);
+  s.child = mem + 5 * (n + 1);
+  s.size = mem + 6 * (n + 1);
+  s.dom = mem + 7 * (n + 1);
+  s.bucket = mem + 8 * (n + 1);
+  s.bucketNext = mem + 9 * (n + 1);
+  s.stack = mem + 10 * (n + 1);
+
+  int numVisited = lt_init_dfs_tree(ctx, &s);
+
+  for (int v=0 ; v<=numVisited ; v++) {
+    s.semi[v] = v;
+    s.label[v] = v;
+    s.size[v] = v == 0 ? 0 : 1;
+  }
+
+  for (int w=numVisited ; w>=2 ; w--) {
+    PoolOffset bb = s.vertex[w];
+    int numPreds;
+    const PoolOffset *preds = dom_graph_preds(&ctx->domGraph, bb, &numPreds);
+
+    for (int i=0 ; i<numPreds ; i++) {
+      int v = ctx->cfgNodePool.preNumbers[preds[i]] + 1;
+
+      // Preds unreachable from the entry are not part of the DFS tree.
+      if (v == 0) {
+        continue;
+      }
+
+      int u = lt_eval(&s, v, balanced);
+      if (s.semi[u] < s.semi[w]) {
+        s.semi[w] = s.semi[u];
+      }
+    }
+
+    s.bucketNext[w] = s.bucket[s.semi[w]];
+    s.bucket[s.semi[w]] = w;
+
+    int p = s.parent[w];
+    lt_link(&s, p, w, balanced);
+
+    for (int v=s.bucket[p] ; v != 0 ; v=s.bucketNext[v]) {
+      int u = lt_eval(&s, v, balanced);
+      s.dom[v] = s.semi[u] < s.semi[v] ? u : p;
+    }
+    s.bucket[p] = 0;
+  }
+
+  for (int w=2 ; w<=numVisited ; w++) {
+    if (s.dom[w] != s.semi[w]) {
+      s.dom[w] = s.dom[s.dom[w]];
+    }
+  }
+
+  ctx->cfgNodePool.idoms[s.vertex[1]] = s.vertex[1];
+  for (int w=2 ; w<=numVisited ; w++) {
+    ctx->cfgNodePool.idoms[s.vertex[w]] = s.vertex[s.dom[w]];
+  }
+}
+
+/// Calculate the immediate dominators of the BBs using the SEMI-NCA
+/// algorithm described in "Finding Dominators in Practice", Georgiadis,
+/// Tarjan and Werneck, 2006.
+///
+/// Semidominators are computed as in Lengauer-Tarjan (with the simple
+/// EVAL). The idom of each BB is then the nearest common ancestor of its
+/// DFS parent and its semidominator in the dominator tree built so far,
+/// which is found by walking up from the parent while the preorder numbers
+/// are larger than the semidominator's.
+static void calculate_dominance_semi_nca(CFGContext *ctx) {
+  int n = ctx->domGraph.numNodes;
+  LTState s;
+  int *mem = arena_alloc(&ctx->arena, 7 * (n + 1) * sizeof(int));
+  memset(mem, 0, 7 * (n + 1) * sizeof(int));
+
+  // SEMI-NCA needs neither buckets nor the balanced forest.
+  s.vertex = mem;
+  s.parent = mem + (n + 1);
+  s.semi = mem + 2 * (n + 1);
+  s.label = mem + 3 * (n + 1);
+  s.ancestor = mem + 4 * (n + 1);
+  s.dom = mem + 5 * (n + 1);
+  s.stack = mem + 6 * (n + 1);
+  s.child = s.size = s.bucket = s.bucketNext = NULL;
+
+  int numVisited = lt_init_dfs_tree(ctx, &s);
+
+  for (int v=0 ; v<=numVisited ; v++) {
+    s.semi[v] = v;
+    s.label[v] = v;
+  }
+
+  for (int w=numVisited ; w>=2 ; w--) {
+    PoolOffset bb = s.vertex[w];
+    int numPreds;
+    const PoolOffset *preds = dom_graph_preds(&ctx->domGraph, bb, &numPreds);
+
+    for (int i=0 ; i<numPreds ; i++) {
+      int v = ctx->cfgNodePool.preNumbers[preds[i]] + 1;
+
+      if (v == 0) {
+        continue;
+      }
+
+      int u = lt_eval(&s, v, FALSE);
+      if (s.semi[u] < s.semi[w]) {
+        s.semi[w] = s.semi[u];
+      }
+    }
+
+    lt_link(&s, s.parent[w], w, FALSE);
+  }
+
+  s.dom[1] = 1;
+  for (int w=2 ; w<=numVisited ; w++) {
+    int d = s.parent[w];
+
+    while (d > s.semi[w]) {
+      d = s.dom[d];
+    }
+    s.dom[w] = d;
+  }
+
+  ctx->cfgNodePool.idoms[s.vertex[1]] = s.vertex[1];
+  for (int w=2 ; w<=numVisited ; w++) {
+    ctx->cfgNodePool.idoms[s.vertex[w]] = s.vertex[s.dom[w]];
+  }
+}
+
+/// Fills the vertex and parent arrays from the DFS computed by
+/// calculate_dfs_orders. Returns the number of BBs reachable from the
+/// entry.
+static int lt_init_dfs_tree(CFGContext *ctx, LTState *s) {
+  for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+    PoolOffset bb = ctx->preorder[i];
+    s->vertex[i+1] = bb;
+    s->parent[i+1] = i == 0
+      ? 0 : ctx->cfgNodePool.preNumbers[ctx->cfgNodePool.dfsParents[bb]] + 1;
+  }
+
+  return ctx->numReachableCFGNodes;
+}
+
+/// Path compression on the forest maintained by LINK. This is the
+/// recursive COMPRESS of the paper unrolled with an explicit stack since
+/// paths in the forest can be as long as the CFG.
+static void lt_compress(LTState *s, int v) {
+  int top = 0;
+
+  while (s->ancestor[s->ancestor[v]] != 0) {
+    s->stack[top++] = v;
+    v = s->ancestor[v];
+  }
+
+  while (top > 0) {
+    v = s->stack[--top];
+    int a = s->ancestor[v];
+
+    if (s->semi[s->label[a]] < s->semi[s->label[v]]) {
+      s->label[v] = s->label[a];
+    }
+    s->ancestor[v] = s->ancestor[a];
+  }
+}
+
+static int lt_eval(LTState *s, int v, bool balanced) {
+  if (s->ancestor[v] == 0) {
+    return balanced ? s->label[v] : v;
+  }
+
+  lt_compress(s, v);
+
+  if (!balanced) {
+    return s->label[v];
+  }
+
+  int a = s->label[s->ancestor[v]];
+  return s->semi[a] >= s->semi[s->label[v]] ? s->label[v] : a;
+}
+
+static void lt_link(LTState *s, int v, int w, bool balanced) {
+  if (!balanced) {
+    s->ancestor[w] = v;
+    return;
+  }
+
+  int *semi = s->semi;
+  int *label = s->label;
+  int *child = s->child;
+  int *size = s->size;
+  int sv = w;
+
+  while (semi[label[w]] < semi[label[child[sv]]]) {
+    if (size[sv] + size[child[child[sv]]] >= 2 * size[child[sv]]) {
+      s->ancestor[child[sv]] = sv;
+      child[sv] = child[child[sv]];
+    } else {
+      size[child[sv]] = size[sv];
+      sv = s->ancestor[sv] = child[sv];
+    }
+  }
+
+  label[sv] = label[w];
+  size[v] += size[w];
+
+  if (size[v] < 2 * size[w]) {
+    int tmp = sv;
+    sv = child[v];
+    child[v] = tmp;
+  }
+
+  while (sv != 0) {
+    s->ancestor[sv] = v;
+    sv = child[sv];
+  }
+}
+
+/// Updates the dominator set of the BB stored at bbOffset by taking the
+/// intersection of all dom sets of predecessors and adding the BB to the
+/// result.
+///
+/// Returns true if the dom set was changed and false otherwise.
+static bool update_dom_set(CFGContext *ctx, PoolOffset bbOffset,
+                           BitsetWord *domSets, BitsetWord *tempSet,
+                           size_t numWords) {
+  int numPreds;
+  const PoolOffset *preds = dom_graph_preds(&ctx->domGraph, bbOffset,
+                                            &numPreds);
+  BitsetWord *doms = domSets + bbOffset * numWords;
+
+  assert(numPreds > 0 && "Reachable BB without preds");
+
+  // Preds that were not processed yet still hold the full set and so do
+  // not affect the intersection.
+  memcpy(tempSet, domSets + preds[0] * numWords,
+         numWords * sizeof(BitsetWord));
+  for (int i=1 ; i<numPreds ; i++) {
+    bitset_and(tempSet, domSets + preds[i] * numWords, numWords);
+  }
+
+  bitset_set(tempSet, bbOffset);
+
+  if (bitset_equal(tempSet, doms, numWords)) {
+    return FALSE;
+  }
+
+  memcpy(doms, tempSet, numWords * sizeof(BitsetWord));
+  return TRUE;
+}
+
+/// Search table for the BB with the passed bbID and if found return its
+/// offset. Otherwise, append the BB to the table and return its new offset.
+static PoolOffset spec_table_intern(SpecTable *table, BBID bbID) {
+  // Keep the load factor of the index at most 1/2.
+  if (2 * (table->numBBs + 1) > table->indexCapacity) {
+    spec_table_grow_index(table);
+  }
+
+  unsigned mask = table->indexCapacity - 1;
+  unsigned slot = hash_bb_id(bbID) & mask;
+
+  while (table->index[slot] != EMPTY_SLOT) {
+    if (table->ids[table->index[slot]] == bbID) {
+      return table->index[slot];
+    }
+
+    slot = (slot + 1) & mask;
+  }
+
+  // The pool is full, double its size.
+  if (table->numBBs == table->idCapacity) {
+    int capacity = max(1, table->idCapacity*2);
+    table->ids = spec_table_resize(table, table->ids,
+                                   table->idCapacity * sizeof(BBID),
+                                   capacity * sizeof(BBID));
+    table->idCapacity = capacity;
+  }
+
+  table->ids[table->numBBs] = bbID;
+  table->index[slot] = table->numBBs;
+  table->numBBs++;
+  return table->numBBs - 1;
+}
+
+/// Mixes the bits of a BBID so that dense as well as strided ID ranges
+/// spread over the whole index (the finalizer of MurmurHash3).
+static unsigned hash_bb_id(BBID bbID) {
+  unsigned h = (unsigned)bbID;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+/// Doubles the capacity of the BBID index of table and re-inserts all the
+/// BBs currently in it.
+static void spec_table_grow_index(SpecTable *table) {
+  if (table->arena == NULL) {
+    free(table->index);
+  }
+  table->indexCapacity = max(16, table->indexCapacity*2);
+  table->index = spec_table_resize(table, NULL, 0, table->indexCapacity
+                                   * sizeof(PoolOffset));
+
+  for (int i=0 ; i<table->indexCapacity ; i++) {
+    table->index[i] = EMPTY_SLOT;
+  }
+
+  unsigned mask = table->indexCapacity - 1;
+  for (int i=0 ; i<table->numBBs ; i++) {
+    unsigned slot = hash_bb_id(table->ids[i]) & mask;
+
+    while (table->index[slot] != EMPTY_SLOT) {
+      slot = (slot + 1) & mask;
+    }
+
+    table->index[slot] = i;
+  }
+}
+
+static void spec_table_add_edge(SpecTable *table, PoolOffset srcBBOffset,
+                                PoolOffset destBBOffset) {
+  if (table->numEdges == table->edgeCapacity) {
+    size_t oldSize = table->edgeCapacity * sizeof(PoolOffset);
+    table->edgeCapacity = max(16, table->edgeCapacity*2);
+    size_t newSize = table->edgeCapacity * sizeof(PoolOffset);
+    table->edgeSrcs = spec_table_resize(table, table->edgeSrcs, oldSize,
+                                        newSize);
+    table->edgeDests = spec_table_resize(table, table->edgeDests, oldSize,
+                                         newSize);
+  }
+
+  table->edgeSrcs[table->numEdges] = srcBBOffset;
+  table->edgeDests[table->numEdges] = destBBOffset;
+  table->numEdges++;
+}
+
+/// Allocates room for numBBs BBs and numEdges edges in the empty table.
+static void spec_table_reserve(SpecTable *table, int numBBs, int numEdges) {
+  assert(table->numBBs == 0 && table->numEdges == 0
+         && "Reserving room in a table that is not empty");
+
+  if (numBBs > table->idCapacity) {
+    table->ids = spec_table_resize(table, table->ids,
+                                   table->idCapacity * sizeof(BBID),
+                                   numBBs * sizeof(BBID));
+    table->idCapacity = numBBs;
+  }
+
+  if (2 * numBBs > table->indexCapacity) {
+    // grow_index doubles the capacity it starts from.
+    int capacity = 16;
+    while (capacity < 2 * numBBs) {
+      capacity *= 2;
+    }
+    table->indexCapacity = capacity / 2;
+    spec_table_grow_index(table);
+  }
+
+  if (numEdges > table->edgeCapacity) {
+    size_t oldSize = table->edgeCapacity * sizeof(PoolOffset);
+    size_t newSize = numEdges * sizeof(PoolOffset);
+    table->edgeSrcs = spec_table_resize(table, table->edgeSrcs, oldSize,
+                                        newSize);
+    table->edgeDests = spec_table_resize(table, table->edgeDests, oldSize,
+                                         newSize);
+    table->edgeCapacity = numEdges;
+  }
+}
+
+/// Resizes the array at p of table from oldSize to newSize bytes.
+static void *spec_table_resize(SpecTable *table, void *p, size_t oldSize,
+                               size_t newSize) {
+  if (table->arena != NULL) {
+    return arena_grow(table->arena, p, oldSize, newSize);
+  }
+
+  p = realloc(p, newSize);
+  assert(p != NULL && "Ran out of virtual memory\n");
+  return p;
+}
+
+/// Appends the BBs and edges of chunkTable, which was parsed from the lines
+/// following those of table, to table and frees chunkTable (whose arrays
+/// are on the heap). BBs of
+/// chunkTable are interned in their order of appearance so that BBs new to
+/// table get the offsets they would have had if both were parsed as one.
+static void spec_table_merge(SpecTable *table, SpecTable *chunkTable) {
+  PoolOffset *offsets = malloc(max(1, chunkTable->numBBs)
+                               * sizeof(PoolOffset));
+  assert(offsets != NULL && "Ran out of virtual memory\n");
+
+  for (int i=0 ; i<chunkTable->numBBs ; i++) {
+    offsets[i] = spec_table_intern(table, chunkTable->ids[i]);
+  }
+
+  for (int i=0 ; i<chunkTable->numEdges ; i++) {
+    spec_table_add_edge(table, offsets[chunkTable->edgeSrcs[i]],
+                        offsets[chunkTable->edgeDests[i]]);
+  }
+
+  free(offsets);
+  free(chunkTable->ids);
+  free(chunkTable->index);
+  free(chunkTable->edgeSrcs);
+  free(chunkTable->edgeDests);
+  memset(chunkTable, 0, sizeof(SpecTable));
+}
+
+/// Makes the fully parsed cfgSpec the current CFG.
+static void use_parsed_spec(CFGContext *ctx) {
+  ctx->cfgNodePool.ids = ctx->cfgSpec.ids;
+  ctx->currentPoolSize = ctx->cfgSpec.idCapacity;
+  ctx->currentNumCFGNodes = ctx->cfgSpec.numBBs;
+  ctx->numParsedEdges = ctx->cfgSpec.numEdges;
+}
+
+/// Empties the current CFG. The arena owns all of its memory, which is
+/// freed at once (and kept for the next CFG) by resetting the arena, so
+/// this costs the same for any CFG. After this, the CFG no longer points
+/// into the binary CFG it was loaded from (if any), which can then be
+/// released.
+static void reset_graph(CFGContext *ctx) {
+  arena_reset(&ctx->arena);
+  memset(&ctx->cfgSpec, 0, sizeof(ctx->cfgSpec));
+  ctx->cfgSpec.arena = &ctx->arena;
+  memset(&ctx->cfgNodePool, 0, sizeof(ctx->cfgNodePool));
+  memset(&ctx->graphInput, 0, sizeof(ctx->graphInput));
+  ctx->currentPoolSize = 0;
+  ctx->currentNumCFGNodes = 0;
+  ctx->numParsedEdges = 0;
+  ctx->preorder = NULL;
+  ctx->rpot = NULL;
+  ctx->numReachableCFGNodes = 0;
+  ctx->succOffsets = NULL;
+  ctx->succs = NULL;
+  ctx->predOffsets = NULL;
+  ctx->preds = NULL;
+  memset(&ctx->domGraph, 0, sizeof(ctx->domGraph));
+  memset(&ctx->lcaIndex, 0, sizeof(ctx->lcaIndex));
+}
+
+/// Copies the parsed edges into the CSR arrays with a counting sort on the
+/// source (resp. dest) BB. The sort is stable so succs and preds keep the
+/// order in which they appear in the input.
+static void build_csr_graph(CFGContext *ctx) {
+  int n = ctx->currentNumCFGNodes;
+  int m = ctx->numParsedEdges;
+  PoolOffset *edgeSrcs = ctx->cfgSpec.edgeSrcs;
+  PoolOffset *edgeDests = ctx->cfgSpec.edgeDests;
+
+  ctx->succOffsets = arena_alloc(&ctx->arena, (n + 1) * sizeof(int));
+  ctx->predOffsets = arena_alloc(&ctx->arena, (n + 1) * sizeof(int));
+  ctx->succs = arena_alloc(&ctx->arena, m * sizeof(PoolOffset));
+  ctx->preds = arena_alloc(&ctx->arena, m * sizeof(PoolOffset));
+  memset(ctx->succOffsets, 0, (n + 1) * sizeof(int));
+  memset(ctx->predOffsets, 0, (n + 1) * sizeof(int));
+
+  for (int i=0 ; i<m ; i++) {
+    ctx->succOffsets[edgeSrcs[i]+1]++;
+    ctx->predOffsets[edgeDests[i]+1]++;
+  }
+
+  for (int i=0 ; i<n ; i++) {
+    ctx->succOffsets[i+1] += ctx->succOffsets[i];
+    ctx->predOffsets[i+1] += ctx->predOffsets[i];
+  }
+
+  // Use the start offsets as insertion cursors and shift them back once
+  // all edges are placed.
+  for (int i=0 ; i<m ; i++) {
+    ctx->succs[ctx->succOffsets[edgeSrcs[i]]++] = edgeDests[i];
+    ctx->preds[ctx->predOffsets[edgeDests[i]]++] = edgeSrcs[i];
+  }
+
+  for (int i=n ; i>0 ; i--) {
+    ctx->succOffsets[i] = ctx->succOffsets[i-1];
+    ctx->predOffsets[i] = ctx->predOffsets[i-1];
+  }
+  ctx->succOffsets[0] = 0;
+  ctx->predOffsets[0] = 0;
+}
+
+/// Returns the number of bytes held by the pool (including the arrays
+/// filled by the analysis, as far as they are allocated), the BBID index,
+/// the edge list, the CSR arrays and the LCA index of the current CFG.
+static size_t graph_memory_size(CFGContext *ctx) {
+  const CFGNodePool *pool = &ctx->cfgNodePool;
+  const LCAIndex *index = &ctx->lcaIndex;
+  size_t n = ctx->currentNumCFGNodes;
+  size_t size = ctx->currentPoolSize * sizeof(BBID)
+    + ctx->cfgSpec.indexCapacity * sizeof(PoolOffset)
+    + 2 * ctx->cfgSpec.edgeCapacity * sizeof(PoolOffset)
+    + 2 * (n + 1) * sizeof(int)
+    + 2 * ctx->numParsedEdges * sizeof(PoolOffset);
+
+  // The idoms, the four DFS arrays and the two traversal orders, sized for
+  // the virtual exit too, if there is one.
+  if (pool->idoms != NULL) {
+    size += 7 * (size_t)ctx->domGraph.numNodes * sizeof(int)
+      + ctx->domGraph.numExits * sizeof(PoolOffset);
+  }
+  if (pool->domDepths != NULL) {
+    size += n * sizeof(int);
+  }
+  if (pool->domIntervals != NULL) {
+    size += n * sizeof(DomInterval);
+  }
+
+  if (index->domPreorder != NULL) {
+    size += (size_t)ctx->numReachableCFGNodes
+      * (sizeof(PoolOffset) + index->numLevels * sizeof(int));
+  }
+  if (index->jumps != NULL) {
+    size += n * sizeof(PoolOffset);
+  }
+
+  return size;
+}
+
+/// Opens a counter of the cache misses of the calling thread in user space.
+/// Returns -1 if perf events are not available (e.g. not on Linux, no PMU
+/// or perf_event_paranoid forbids it).
+static int open_cache_miss_counter() {
+#ifdef __linux__
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_MISSES;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+static long long read_counter(int fd) {
+  long long value = 0;
+
+  if (fd == -1 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+    return 0;
+  }
+
+  return value;
+}
+
+static int compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static double current_time_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/// Fills the domDepths of the pool. Each BB's IDOM comes before it in
+/// reverse-post-order, so a single pass in that order suffices. The roots
+/// of the tree, which are their own IDOMs, are at depth 0.
+static void calculate_dom_depths(CFGContext *ctx) {
+  CFGNodePool *pool = &ctx->cfgNodePool;
+
+  if (pool->domDepths == NULL) {
+    pool->domDepths = arena_alloc(&ctx->arena, ctx->currentNumCFGNodes
+                                  * sizeof(int));
+  }
+
+  for (int i=0 ; i<ctx->currentNumCFGNodes ; i++) {
+    pool->domDepths[i] = UNDEFINED;
+  }
+
+  for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+    PoolOffset bb = ctx->rpot[i];
+    PoolOffset idom = pool->idoms[bb];
+    pool->domDepths[bb] = idom == bb ? 0 : pool->domDepths[idom] + 1;
+  }
+}
+
+/// Fills the domIntervals of the pool with a preorder numbering of the
+/// dominator tree. Each BB's IDOM comes before it in reverse-post-order, so
+/// subtree sizes are summed up in one pass in the opposite order. A second
+/// pass in reverse-post-order then hands every BB the next free range of
+/// numbers of its IDOM, without a traversal of the tree or lists of its
+/// children. The trees of a post-dominator forest get consecutive ranges.
+static void number_dom_tree(CFGContext *ctx) {
+  CFGNodePool *pool = &ctx->cfgNodePool;
+  int n = ctx->currentNumCFGNodes;
+
+  if (pool->domIntervals == NULL) {
+    pool->domIntervals = arena_alloc(&ctx->arena, n * sizeof(DomInterval));
+  }
+
+  DomInterval *intervals = pool->domIntervals;
+  int *nextPre = arena_alloc(&ctx->arena, n * sizeof(int));
+  int nextRootPre = 0;
+
+  for (int i=0 ; i<n ; i++) {
+    intervals[i].pre = UNDEFINED;
+    intervals[i].size = 0;
+  }
+
+  for (int i=ctx->numReachableCFGNodes-1 ; i>=0 ; i--) {
+    PoolOffset bb = ctx->rpot[i];
+
+    intervals[bb].size++;
+    if (pool->idoms[bb] != bb) {
+      intervals[pool->idoms[bb]].size += intervals[bb].size;
+    }
+  }
+
+  for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+    PoolOffset bb = ctx->rpot[i];
+    PoolOffset idom = pool->idoms[bb];
+
+    if (idom == bb) {
+      intervals[bb].pre = nextRootPre;
+      nextRootPre += intervals[bb].size;
+    } else {
+      intervals[bb].pre = nextPre[idom];
+      nextPre[idom] += intervals[bb].size;
+    }
+    nextPre[bb] = intervals[bb].pre + 1;
+  }
+}
+
+/// Fills the sparse table of ctx->lcaIndex. This is the range minimum
+/// structure over the Euler tour of the dominator tree, but it only needs
+/// an entry per BB rather than per tour step: for BBs numbered p1 < p2 in
+/// preorder, their nearest common ancestor is the IDOM with the smallest
+/// number among the IDOMs of the BBs numbered p1+1 .. p2. That range holds
+/// the child of the ancestor on the way to the second BB, and nothing
+/// outside of the ancestor's subtree.
+static void build_lca_table(CFGContext *ctx) {
+  LCAIndex *index = &ctx->lcaIndex;
+  const DomInterval *intervals = ctx->cfgNodePool.domIntervals;
+  const PoolOffset *idoms = ctx->cfgNodePool.idoms;
+  int n = ctx->numReachableCFGNodes;
+
+  index->domPreorder = arena_alloc(&ctx->arena, n * sizeof(PoolOffset));
+  for (PoolOffset bb=0 ; bb<ctx->currentNumCFGNodes ; bb++) {
+    if (intervals[bb].pre != UNDEFINED) {
+      index->domPreorder[intervals[bb].pre] = bb;
+    }
+  }
+
+  index->numLevels = 1;
+  while (n >> index->numLevels > 0) {
+    index->numLevels++;
+  }
+
+  index->table = arena_alloc(&ctx->arena, (size_t)index->numLevels * n
+                             * sizeof(int));
+
+  for (int i=0 ; i<n ; i++) {
+    index->table[i] = intervals[idoms[index->domPreorder[i]]].pre;
+  }
+
+  for (int k=1 ; k<index->numLevels ; k++) {
+    const int *prev = index->table + (size_t)(k - 1) * n;
+    int *row = index->table + (size_t)k * n;
+    int half = 1 << (k - 1);
+
+    for (int i=0 ; i + 2 * half <= n ; i++) {
+      row[i] = prev[i] < prev[i + half] ? prev[i] : prev[i + half];
+    }
+  }
+}
+
+/// Returns the nearest common dominator of the BBs numbered pre1 and pre2
+/// in the preorder of the dominator tree, from two overlapping ranges of
+/// the sparse table, or UNDEFINED if they lie in different trees of a
+/// post-dominator forest.
+static PoolOffset lca_from_table(const CFGContext *ctx, int pre1, int pre2) {
+  const LCAIndex *index = &ctx->lcaIndex;
+
+  if (pre1 == pre2) {
+    return index->domPreorder[pre1];
+  }
+
+  int begin = (pre1 < pre2 ? pre1 : pre2) + 1;
+  int end = (pre1 < pre2 ? pre2 : pre1) + 1;
+  int k = 31 - __builtin_clz(end - begin);
+  const int *row = index->table + (size_t)k * ctx->numReachableCFGNodes;
+  int a = row[begin];
+  int b = row[end - (1 << k)];
+  PoolOffset lca = index->domPreorder[a < b ? a : b];
+
+  // In a post-dominator forest, BBs of different trees only have the
+  // virtual exit in common, and the minimum is then a BB that misses one
+  // of them.
+  if (ctx->opts.postDominators) {
+    const DomInterval *interval = &ctx->cfgNodePool.domIntervals[lca];
+
+    if (interval->pre >= begin || interval->pre + interval->size < end) {
+      return UNDEFINED;
+    }
+  }
+
+  return lca;
+}
+
+/// Fills the jump pointers of ctx->lcaIndex, the low memory alternative to
+/// the sparse table: an int per BB instead of one per BB and level, for
+/// O(log n) rather than O(1) queries. Binary lifting stores the 2^k-th
+/// ancestor of every BB for every k. Jump pointers in the skew-binary
+/// scheme of Myers ("An applicative random-access stack", 1983) store a
+/// single ancestor per BB, yet still reach any ancestor in O(log n) jumps
+/// and steps to an IDOM. The jumps of a BB only depend on its depth, so BBs
+/// of the same depth jump in lockstep.
+static void build_lca_jumps(CFGContext *ctx) {
+  LCAIndex *index = &ctx->lcaIndex;
+  const PoolOffset *idoms = ctx->cfgNodePool.idoms;
+
+  calculate_dom_depths(ctx);
+  const int *depths = ctx->cfgNodePool.domDepths;
+
+  index->jumps = arena_alloc(&ctx->arena, ctx->currentNumCFGNodes
+                             * sizeof(PoolOffset));
+
+  for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+    PoolOffset bb = ctx->rpot[i];
+    PoolOffset idom = idoms[bb];
+
+    // The roots come first in reverse-post-order and are their own jumps.
+    if (idom == bb) {
+      index->jumps[bb] = bb;
+      continue;
+    }
+
+    // If the IDOM's jump spans as many levels as the jump after it, the
+    // two make one jump twice as long, otherwise the BB jumps to its IDOM.
+    PoolOffset jump = index->jumps[idom];
+    if (depths[idom] - depths[jump]
+        == depths[jump] - depths[index->jumps[jump]]) {
+      index->jumps[bb] = index->jumps[jump];
+    } else {
+      index->jumps[bb] = idom;
+    }
+  }
+}
+
+/// Returns the nearest common dominator of bb1 and bb2 by climbing the
+/// dominator tree with the jump pointers, or UNDEFINED if they lie in
+/// different trees of a post-dominator forest.
+static PoolOffset lca_by_jumps(const CFGContext *ctx, PoolOffset bb1,
+                               PoolOffset bb2) {
+  const PoolOffset *jumps = ctx->lcaIndex.jumps;
+  const PoolOffset *idoms = ctx->cfgNodePool.idoms;
+  const int *depths = ctx->cfgNodePool.domDepths;
+
+  if (depths[bb1] < depths[bb2]) {
+    PoolOffset bb = bb1;
+    bb1 = bb2;
+    bb2 = bb;
+  }
+
+  while (depths[bb1] > depths[bb2]) {
+    bb1 = depths[jumps[bb1]] >= depths[bb2] ? jumps[bb1] : idoms[bb1];
+  }
+
+  while (bb1 != bb2) {
+    if (jumps[bb1] != jumps[bb2]) {
+      // Only the roots of a post-dominator forest jump to themselves.
+      if (jumps[bb1] == bb1) {
+        return UNDEFINED;
+      }
+      bb1 = jumps[bb1];
+      bb2 = jumps[bb2];
+    } else {
+      bb1 = idoms[bb1];
+      bb2 = idoms[bb2];
+    }
+  }
+
+  return bb1;
+}
+
+/// Stores the dominators of the BB at bbOffset in doms, ordered from the
+/// root of its tree (the entry BB) down to the BB itself, and returns their
+/// number. The set is
+/// derived by walking up the dominator tree so doms must have room for as
+/// many offsets as there are BBs in the CFG.
+static int get_dom_set(CFGContext *ctx, PoolOffset bbOffset,
+                       PoolOffset *doms) {
+  int numDoms = 1;
+  for (PoolOffset d=bbOffset ; ctx->cfgNodePool.idoms[d] != d ;
+       d=ctx->cfgNodePool.idoms[d]) {
+    numDoms++;
+  }
+
+  PoolOffset d = bbOffset;
+  for (int i=numDoms-1 ; i>=0 ; i--) {
+    doms[i] = d;
+    d = ctx->cfgNodePool.idoms[d];
+  }
+
+  return numDoms;
+}
+
+/// Prints the BBs reachable from the entry in reverse-post-order, in the
+/// format selected by ctx->opts.outputFormat, after the CFG's delimiter
+/// line name (if it is not NULL).
+static void print_analysis(CFGContext *ctx, const char *name,
+                           int nameLength) {
+  OutBuffer *out = &ctx->out;
+
+  switch (ctx->opts.outputFormat) {
+  case CFG_OUTPUT_FULL:
+  case CFG_OUTPUT_IDOMS:
+    if (name != NULL) {
+      out_buffer_write(out, name, nameLength);
+      out_buffer_put_literal(out, "\n");
+    }
+    break;
+  case CFG_OUTPUT_JSON:
+    print_json(ctx, name, nameLength);
+    return;
+  case CFG_OUTPUT_BINARY:
+    print_binary_result(ctx, name, nameLength);
+    return;
+  case CFG_OUTPUT_DOT:
+  case CFG_OUTPUT_DOT_CFG:
+  case CFG_OUTPUT_DOT_DOM_TREE:
+    print_dot(ctx, name, nameLength);
+    return;
+  }
+
+  if (ctx->opts.outputFormat == CFG_OUTPUT_IDOMS) {
+    print_idoms(ctx);
+  } else {
+    PoolOffset *domsScratch = arena_alloc(&ctx->arena, ctx->currentNumCFGNodes
+                                          * sizeof(PoolOffset));
+
+    for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+      print_cfg_node(ctx, ctx->rpot[i], domsScratch);
+    }
+  }
+}
+
+/// Prints a "BBID IDOM" line, or "BBID IDOM DEPTH" if ctx->opts.printDepths
+/// is set, for each BB reachable from the entry in reverse-post-order.
+static void print_idoms(CFGContext *ctx) {
+  OutBuffer *out = &ctx->out;
+  const BBID *ids = ctx->cfgNodePool.ids;
+  const PoolOffset *idoms = ctx->cfgNodePool.idoms;
+
+  if (ctx->opts.printDepths) {
+    calculate_dom_depths(ctx);
+  }
+
+  for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+    PoolOffset bb = ctx->rpot[i];
+
+    out_buffer_put_int(out, ids[bb]);
+    out_buffer_put_literal(out, " ");
+    out_buffer_put_int(out, ids[idoms[bb]]);
+    if (ctx->opts.printDepths) {
+      out_buffer_put_literal(out, " ");
+      out_buffer_put_int(out, ctx->cfgNodePool.domDepths[bb]);
+    }
+    out_buffer_put_literal(out, "\n");
+  }
+}
+
+/// Prints the BBs in CFG_OUTPUT_JSON, one object at a time: the reachable
+/// BBs in reverse-post-order, then the unreachable ones in pool order.
+static void print_json(CFGContext *ctx, const char *name, int nameLength) {
+  OutBuffer *out = &ctx->out;
+
+  if (name != NULL) {
+    out_buffer_put_literal(out, "{\"cfg\":");
+    print_quoted(ctx, name, nameLength);
+    out_buffer_put_literal(out, "}\n");
+  }
+
+  calculate_dom_depths(ctx);
+
+  for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+    print_json_bb(ctx, ctx->rpot[i]);
+  }
+
+  if (ctx->numReachableCFGNodes < ctx->currentNumCFGNodes) {
+    for (PoolOffset bb=0 ; bb<ctx->currentNumCFGNodes ; bb++) {
+      if (ctx->cfgNodePool.idoms[bb] == UNDEFINED) {
+        print_json_bb(ctx, bb);
+      }
+    }
+  }
+}
+
+/// Prints the JSON object of the BB at bbOffset, with a null idom and
+/// depth if it is unreachable.
+static void print_json_bb(CFGContext *ctx, PoolOffset bbOffset) {
+  OutBuffer *out = &ctx->out;
+  const BBID *ids = ctx->cfgNodePool.ids;
+  PoolOffset idom = ctx->cfgNodePool.idoms[bbOffset];
+  int firstPred = ctx->predOffsets[bbOffset];
+  int firstSucc = ctx->succOffsets[bbOffset];
+
+  out_buffer_put_literal(out, "{\"id\":");
+  out_buffer_put_int(out, ids[bbOffset]);
+  out_buffer_put_literal(out, ",\"preds\":");
+  print_json_array(ctx, ctx->preds + firstPred,
+                   ctx->predOffsets[bbOffset+1] - firstPred);
+  out_buffer_put_literal(out, ",\"succs\":");
+  print_json_array(ctx, ctx->succs + firstSucc,
+                   ctx->succOffsets[bbOffset+1] - firstSucc);
+  if (idom == UNDEFINED) {
+    out_buffer_put_literal(out, ",\"idom\":null,\"depth\":null}\n");
+    return;
+  }
+  out_buffer_put_literal(out, ",\"idom\":");
+  out_buffer_put_int(out, ids[idom]);
+  out_buffer_put_literal(out, ",\"depth\":");
+  out_buffer_put_int(out, ctx->cfgNodePool.domDepths[bbOffset]);
+  out_buffer_put_literal(out, "}\n");
+}
+
+/// Prints the length bytes at s as a quoted JSON string, which DOT accepts
+/// as well.
+static void print_quoted(CFGContext *ctx, const char *s, int length) {
+  OutBuffer *out = &ctx->out;
+
+  out_buffer_put_literal(out, "\"");
+  for (int i=0 ; i<length ; i++) {
+    unsigned char c = s[i];
+
+    if (c == '"' || c == '\\') {
+      out_buffer_put_literal(out, "\\");
+      out_buffer_write(out, s + i, 1);
+    } else if (c < 0x20) {
+      out_buffer_put_literal(out, "\\u00");
+      out_buffer_write(out, &"0123456789abcdef"[c >> 4], 1);
+      out_buffer_write(out, &"0123456789abcdef"[c & 0xf], 1);
+    } else {
+      out_buffer_write(out, s + i, 1);
+    }
+  }
+  out_buffer_put_literal(out, "\"");
+}
+
+/// Prints the BBIDs of numBBs BBs as a JSON array.
+static void print_json_array(CFGContext *ctx, const PoolOffset *bbOffsets,
+                             int numBBs) {
+  OutBuffer *out = &ctx->out;
+
+  out_buffer_put_literal(out, "[");
+  for (int i=0 ; i<numBBs ; i++) {
+    if (i > 0) {
+      out_buffer_put_literal(out, ",");
+    }
+    out_buffer_put_int(out, ctx->cfgNodePool.ids[bbOffsets[i]]);
+  }
+  out_buffer_put_literal(out, "]");
+}
+
+/// Prints a result record of the binary format of cfg_binary.h. The arrays
+/// of the pool are written as they are, so nothing is copied but into the
+/// output buffer, and arrays of a megabyte or more not even there.
+static void print_binary_result(CFGContext *ctx, const char *name,
+                                int nameLength) {
+  OutBuffer *out = &ctx->out;
+  CFGNodePool *pool = &ctx->cfgNodePool;
+  size_t n = ctx->currentNumCFGNodes;
+  CFGResultHeader header;
+  static const char padding[4];
+
+  cfg_result_init_header(&header, ctx->opts.postDominators
+                         ? CFG_RESULT_POST_DOMINATORS : 0,
+                         n, ctx->numReachableCFGNodes,
+                         name != NULL ? nameLength : 0);
+  out_buffer_write(out, (const char *)&header, sizeof(header));
+
+  if (header.nameSize > 0) {
+    out_buffer_write(out, name, nameLength);
+    out_buffer_write(out, padding, header.nameSize - nameLength);
+  }
+
+  if (n == 0) {
+    return;
+  }
+
+  calculate_dom_depths(ctx);
+
+  // The idoms of unreachable BBs are already UNDEFINED, which is -1.
+  out_buffer_write(out, (const char *)pool->ids, n * sizeof(BBID));
+  out_buffer_write(out, (const char *)pool->idoms, n * sizeof(PoolOffset));
+  out_buffer_write(out, (const char *)pool->domDepths, n * sizeof(int));
+  out_buffer_write(out, (const char *)ctx->rpot,
+                   ctx->numReachableCFGNodes * sizeof(PoolOffset));
+}
+
+/// Prints the CFG, its dominator tree or both as a GraphViz digraph named
+/// after the CFG's delimiter line, according to ctx->opts.outputFormat.
+/// Nodes are named by their BBIDs, which are valid DOT IDs, and are only
+/// declared on their own if they need attributes or have no edges, so the
+/// graph is written straight from the CSR arrays and the pool.
+static void print_dot(CFGContext *ctx, const char *name, int nameLength) {
+  OutBuffer *out = &ctx->out;
+  CFGNodePool *pool = &ctx->cfgNodePool;
+  bool cfgEdges = ctx->opts.outputFormat != CFG_OUTPUT_DOT_DOM_TREE;
+  bool domEdges = ctx->opts.outputFormat != CFG_OUTPUT_DOT_CFG;
+
+  out_buffer_put_literal(out, "digraph ");
+  if (name != NULL) {
+    print_quoted(ctx, name, nameLength);
+  } else {
+    out_buffer_put_literal(out, "cfg");
+  }
+  out_buffer_put_literal(out, " {\n  node [shape=box];\n");
+
+  if (ctx->currentNumCFGNodes > 0) {
+    out_buffer_put_literal(out, "  ");
+    out_buffer_put_int(out, pool->ids[0]);
+    out_buffer_put_literal(out, " [shape=doubleoctagon];\n");
+  }
+
+  if (cfgEdges) {
+    for (PoolOffset bb=0 ; bb<ctx->currentNumCFGNodes ; bb++) {
+      // The dominator tree has no unreachable BBs (or, for post-dominators,
+      // BBs reaching no exit).
+      if (pool->preNumbers[bb] == UNDEFINED) {
+        out_buffer_put_literal(out, "  ");
+        out_buffer_put_int(out, pool->ids[bb]);
+        out_buffer_put_literal(out, " [style=dashed];\n");
+      }
+
+      for (int e=ctx->succOffsets[bb] ; e<ctx->succOffsets[bb+1] ; e++) {
+        out_buffer_put_literal(out, "  ");
+        out_buffer_put_int(out, pool->ids[bb]);
+        out_buffer_put_literal(out, " -> ");
+        out_buffer_put_int(out, pool->ids[ctx->succs[e]]);
+        out_buffer_put_literal(out, ";\n");
+      }
+    }
+  }
+
+  if (domEdges) {
+    // Overlaid on the CFG, the tree edges must not change its layout.
+    const char *attributes = cfgEdges
+      ? " [style=dotted, color=blue, constraint=false];\n" : ";\n";
+    size_t attributesLength = strlen(attributes);
+
+    for (int i=0 ; i<ctx->numReachableCFGNodes ; i++) {
+      PoolOffset bb = ctx->rpot[i];
+
+      if (pool->idoms[bb] == bb) {
+        continue;
+      }
+
+      out_buffer_put_literal(out, "  ");
+      out_buffer_put_int(out, pool->ids[pool->idoms[bb]]);
+      out_buffer_put_literal(out, " -> ");
+      out_buffer_put_int(out, pool->ids[bb]);
+      out_buffer_write(out, attributes, attributesLength);
+    }
+  }
+
+  out_buffer_put_literal(out, "}\n");
+}
+
+static void print_cfg_node(CFGContext *ctx, PoolOffset bbOffset,
+                           PoolOffset *domsScratch) {
+  OutBuffer *out = &ctx->out;
+  int numDoms = get_dom_set(ctx, bbOffset, domsScratch);
+
+  out_buffer_put_literal(out, "==================\nBBID: ");
+  out_buffer_put_int(out, ctx->cfgNodePool.ids[bbOffset]);
+
+  int firstPred = ctx->predOffsets[bbOffset];
+  out_buffer_put_literal(out, "\n# Preds: ");
+  print_bb_list(ctx, ctx->preds + firstPred,
+                ctx->predOffsets[bbOffset+1] - firstPred);
+
+  int firstSucc = ctx->succOffsets[bbOffset];
+  out_buffer_put_literal(out, "# Succs: ");
+  print_bb_list(ctx, ctx->succs + firstSucc,
+                ctx->succOffsets[bbOffset+1] - firstSucc);
+
+  out_buffer_put_literal(out, "# Doms: ");
+  print_bb_list(ctx, domsScratch, numDoms);
+
+  out_buffer_put_literal(out, "------------------\n");
+}
+
+/// Prints the number of BBs followed by their BBIDs, as in "2 [3, 5]".
+static void print_bb_list(CFGContext *ctx, const PoolOffset *bbOffsets,
+                          int numBBs) {
+  OutBuffer *out = &ctx->out;
+
+  out_buffer_put_int(out, numBBs);
+  out_buffer_put_literal(out, " [");
+  for (int i=0 ; i<numBBs ; i++) {
+    if (i > 0) {
+      out_buffer_put_literal(out, ", ");
     }
+    out_buffer_put_int(out, ctx->cfgNodePool.ids[bbOffsets[i]]);
   }
-  log("]\n"); 
+  out_buffer_put_literal(out, "]\n");
 }
@@ -0,0 +1,192 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/cfg_binary.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Binary CFG files are only supported on little-endian targets"
+#endif
+
+static const char *check_csr(int32_t numBBs, int32_t numEdges,
+                             const int32_t *offsets, const int32_t *targets);
+static const char *check_preds(const CFGBinaryView *view);
+
+int cfg_binary_is_binary(const void *data, size_t size) {
+  return size >= 8 && memcmp(data, CFG_BINARY_MAGIC, 8) == 0;
+}
+
+const char *cfg_binary_view(const void *data, size_t size,
+                            CFGBinaryView *view) {
+  const CFGBinaryHeader *header = data;
+
+  if (!cfg_binary_is_binary(data, size)) {
+    return "bad magic";
+  }
+
+  if (size < sizeof(CFGBinaryHeader)) {
+    return "truncated file";
+  }
+
+  if (header->version != CFG_BINARY_VERSION) {
+    return "unsupported version";
+  }
+
+  if (header->numBBs > INT32_MAX - 1 || header->numEdges > INT32_MAX) {
+    return "too many BBs or edges";
+  }
+
+  int hasIDs = (header->flags & CFG_BINARY_HAS_IDS) != 0;
+  uint64_t numInts = 2 * ((uint64_t)header->numBBs + 1)
+    + 2 * (uint64_t)header->numEdges + (hasIDs ? header->numBBs : 0);
+
+  if (size < sizeof(CFGBinaryHeader) + numInts * sizeof(int32_t)) {
+    return "truncated file";
+  }
+
+  if (header->numBBs > 0 && header->entry != 0) {
+    return "entry is not BB 0";
+  }
+
+  const int32_t *p = (const int32_t *)(header + 1);
+  view->numBBs = header->numBBs;
+  view->numEdges = header->numEdges;
+  view->succOffsets = p;
+  p += view->numBBs + 1;
+  view->succs = p;
+  p += view->numEdges;
+  view->predOffsets = p;
+  p += view->numBBs + 1;
+  view->preds = p;
+  p += view->numEdges;
+  view->ids = hasIDs ? p : NULL;
+
+  const char *error = check_csr(view->numBBs, view->numEdges,
+                                view->succOffsets, view->succs);
+  if (error == NULL) {
+    error = check_csr(view->numBBs, view->numEdges,
+                      view->predOffsets, view->preds);
+  }
+  if (error == NULL) {
+    error = check_preds(view);
+  }
+
+  return error;
+}
+
+/// Checks that offsets and targets form a valid CSR adjacency of numBBs BBs
+/// and numEdges edges, so that the analysis never indexes out of bounds.
+static const char *check_csr(int32_t numBBs, int32_t numEdges,
+                             const int32_t *offsets, const int32_t *targets) {
+  if (offsets[0] != 0 || offsets[numBBs] != numEdges) {
+    return "bad edge offsets";
+  }
+
+  for (int32_t i=0 ; i<numBBs ; i++) {
+    if (offsets[i] > offsets[i+1]) {
+      return "bad edge offsets";
+    }
+  }
+
+  for (int32_t i=0 ; i<numEdges ; i++) {
+    if ((uint32_t)targets[i] >= (uint32_t)numBBs) {
+      return "edge to a BB out of range";
+    }
+  }
+
+  return NULL;
+}
+
+/// Checks that the preds of view are the transpose of its succs: that the
+/// preds of every BB are exactly the BBs with an edge to it, as many times
+/// as they have one, in any order. The engines rely on this and assume
+/// that a BB with a pred is reachable from it. Both halves must already be
+/// valid CSR adjacencies.
+static const char *check_preds(const CFGBinaryView *view) {
+  int32_t n = view->numBBs;
+  int32_t *counts = calloc(n + 1, sizeof(int32_t));
+  int32_t *expected = malloc((view->numEdges + 1) * sizeof(int32_t));
+  const char *error = NULL;
+  assert(counts != NULL && expected != NULL
+         && "Ran out of virtual memory\n");
+
+  for (int32_t i=0 ; i<view->numEdges ; i++) {
+    counts[view->succs[i]]++;
+  }
+
+  for (int32_t i=0 ; i<n && error == NULL ; i++) {
+    if (counts[i] != view->predOffsets[i+1] - view->predOffsets[i]) {
+      error = "preds do not match succs";
+    }
+    counts[i] = view->predOffsets[i];
+  }
+
+  // Lay the sources of the succ edges out like the preds, so that the preds
+  // of BB i are compared to expected[predOffsets[i]] ..
+  // expected[predOffsets[i+1]-1].
+  for (int32_t src=0 ; src<n && error == NULL ; src++) {
+    for (int32_t j=view->succOffsets[src] ; j<view->succOffsets[src+1] ;
+         j++) {
+      expected[counts[view->succs[j]]++] = src;
+    }
+  }
+
+  // counts is all zeros again after each BB if its preds and expected
+  // sources are the same multiset.
+  memset(counts, 0, n * sizeof(int32_t));
+
+  for (int32_t i=0 ; i<n && error == NULL ; i++) {
+    for (int32_t j=view->predOffsets[i] ; j<view->predOffsets[i+1] ; j++) {
+      counts[expected[j]]++;
+    }
+
+    for (int32_t j=view->predOffsets[i] ; j<view->predOffsets[i+1] ; j++) {
+      if (--counts[view->preds[j]] < 0) {
+        error = "preds do not match succs";
+        break;
+      }
+    }
+  }
+
+  free(counts);
+  free(expected);
+  return error;
+}
+
+int cfg_binary_write(FILE *out, const CFGBinaryView *view) {
+  CFGBinaryHeader header;
+  size_t n = view->numBBs;
+  size_t m = view->numEdges;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CFG_BINARY_MAGIC, 8);
+  header.version = CFG_BINARY_VERSION;
+  header.flags = view->ids != NULL ? CFG_BINARY_HAS_IDS : 0;
+  header.numBBs = n;
+  header.numEdges = m;
+  header.entry = 0;
+
+  int ok = fwrite(&header, sizeof(header), 1, out) == 1
+    && fwrite(view->succOffsets, sizeof(int32_t), n+1, out) == n+1
+    && fwrite(view->succs, sizeof(int32_t), m, out) == m
+    && fwrite(view->predOffsets, sizeof(int32_t), n+1, out) == n+1
+    && fwrite(view->preds, sizeof(int32_t), m, out) == m;
+
+  if (ok && view->ids != NULL) {
+    ok = fwrite(view->ids, sizeof(int32_t), n, out) == n;
+  }
+
+  return ok && fflush(out) == 0;
+}
+
+void cfg_result_init_header(CFGResultHeader *header, uint32_t flags,
+                            int32_t numBBs, int32_t numReachable,
+                            int nameLength) {
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, CFG_RESULT_MAGIC, 8);
+  header->version = CFG_RESULT_VERSION;
+  header->flags = flags;
+  header->numBBs = numBBs;
+  header->numReachable = numReachable;
+  header->nameSize = (nameLength + 3) & ~3;
+}
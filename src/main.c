@@ -1,7 +1,196 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
 #include "../include/cfg.h"
 
-int main() {
-  parse_cgf_from_file(stdin);
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+typedef struct NamedValue {
+  const char *name;
+  int value;
+} NamedValue;
+
+// The first entry of each table is the default.
+static const NamedValue engines[] = {
+  { "auto", DOM_ENGINE_AUTO },
+  { "iterative", DOM_ENGINE_ITERATIVE },
+  { "chk", DOM_ENGINE_CHK },
+  { "lt", DOM_ENGINE_LT },
+  { "lt-balanced", DOM_ENGINE_LT_BALANCED },
+  { "semi-nca", DOM_ENGINE_SEMI_NCA },
+};
+
+static const NamedValue parsers[] = {
+  { "simd", CFG_PARSER_SIMD },
+  { "scan", CFG_PARSER_SCAN },
+  { "strtok", CFG_PARSER_STRTOK },
+};
+
+static const NamedValue formats[] = {
+  { "full", CFG_OUTPUT_FULL },
+  { "idom", CFG_OUTPUT_IDOMS },
+  { "json", CFG_OUTPUT_JSON },
+  { "binary", CFG_OUTPUT_BINARY },
+  { "dot", CFG_OUTPUT_DOT },
+  { "dot-cfg", CFG_OUTPUT_DOT_CFG },
+  { "dot-domtree", CFG_OUTPUT_DOT_DOM_TREE },
+};
+
+static void print_names(const NamedValue *table, size_t size) {
+  for (size_t i=0 ; i<size ; i++) {
+    fprintf(stderr, " %s", table[i].name);
+  }
+  fprintf(stderr, " (default: %s)\n", table[0].name);
+}
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-s] [-e engine] [-t blocks] [-p parser] "
+          "[-j threads] [-f format] [-d] [-P] [-c binary-cfg]\n"
+          "       [-o file | -O fd] [cfg-spec]\n", prog);
+  fprintf(stderr, "Reads the CFG spec from stdin if no file is given.\n");
+  fprintf(stderr, "  -s  print per-phase statistics to stderr\n");
+  fprintf(stderr, "  -e  dominance engine, one of:");
+  print_names(engines, ARRAY_SIZE(engines));
+  fprintf(stderr, "  -t  min number of blocks for which the auto engine "
+          "picks semi-nca (default: %d)\n", DEFAULT_AUTO_ENGINE_THRESHOLD);
+  fprintf(stderr, "  -p  input parser, one of:");
+  print_names(parsers, ARRAY_SIZE(parsers));
+  fprintf(stderr, "  -j  number of threads analysing the CFGs of a multi-CFG "
+          "input, or parsing\n      a single CFG with the simd and scan "
+          "parsers (default: 1)\n");
+  fprintf(stderr, "  -f  output format, one of:");
+  print_names(formats, ARRAY_SIZE(formats));
+  fprintf(stderr, "      full prints the preds, succs and dominators of "
+          "every block, idom one\n      \"block idom\" line per block, "
+          "json one JSON object per block, binary a\n      result "
+          "record per CFG (see cfg_binary.h), and dot a GraphViz graph of "
+          "the CFG\n      overlaid with its dominator tree, or of only one "
+          "of them with dot-cfg\n      and dot-domtree\n");
+  fprintf(stderr, "  -d  also print the depth of each block in the dominator "
+          "tree (idom format)\n");
+  fprintf(stderr, "  -P  compute post-dominators instead of dominators; "
+          "blocks that no other\n      block post-dominates are their own "
+          "immediate post-dominator\n");
+  fprintf(stderr, "  -c  convert the CFG to the binary format, written to "
+          "binary-cfg, instead\n      of analysing it\n");
+  fprintf(stderr, "  -o  write the analysis to file instead of stdout\n");
+  fprintf(stderr, "  -O  write the analysis to the open file descriptor fd "
+          "instead of stdout\n");
+}
+
+static int lookup_name(const NamedValue *table, size_t size, const char *name,
+                       int *value) {
+  for (size_t i=0 ; i<size ; i++) {
+    if (strcmp(table[i].name, name) == 0) {
+      *value = table[i].value;
+      return 1;
+    }
+  }
 
   return 0;
 }
+
+int main(int argc, char **argv) {
+  CFGOptions opts = { 0 };
+  int value;
+  int opt;
+
+  opts.engine = DOM_ENGINE_AUTO;
+  opts.autoEngineThreshold = DEFAULT_AUTO_ENGINE_THRESHOLD;
+  opts.parser = CFG_PARSER_SIMD;
+  opts.numThreads = 1;
+  opts.outputFd = STDOUT_FILENO;
+
+  while ((opt = getopt(argc, argv, "se:t:p:j:f:dPc:o:O:h")) != -1) {
+    switch (opt) {
+    case 's':
+      opts.printStats = 1;
+      break;
+    case 'e':
+      if (!lookup_name(engines, ARRAY_SIZE(engines), optarg, &value)) {
+        fprintf(stderr, "Unknown dominance engine: %s\n", optarg);
+        print_usage(argv[0]);
+        return 1;
+      }
+      opts.engine = value;
+      break;
+    case 't':
+      opts.autoEngineThreshold = atoi(optarg);
+      break;
+    case 'p':
+      if (!lookup_name(parsers, ARRAY_SIZE(parsers), optarg, &value)) {
+        fprintf(stderr, "Unknown parser: %s\n", optarg);
+        print_usage(argv[0]);
+        return 1;
+      }
+      opts.parser = value;
+      break;
+    case 'j':
+      opts.numThreads = atoi(optarg);
+      break;
+    case 'f':
+      if (!lookup_name(formats, ARRAY_SIZE(formats), optarg, &value)) {
+        fprintf(stderr, "Unknown output format: %s\n", optarg);
+        print_usage(argv[0]);
+        return 1;
+      }
+      opts.outputFormat = value;
+      break;
+    case 'd':
+      opts.printDepths = 1;
+      break;
+    case 'P':
+      opts.postDominators = 1;
+      break;
+    case 'c':
+      opts.binaryOutput = fopen(optarg, "wb");
+      if (opts.binaryOutput == NULL) {
+        perror(optarg);
+        return 1;
+      }
+      break;
+    case 'o':
+      opts.outputFd = open(optarg, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if (opts.outputFd == -1) {
+        perror(optarg);
+        return 1;
+      }
+      break;
+    case 'O':
+      opts.outputFd = atoi(optarg);
+      break;
+    default:
+      print_usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  FILE *in = stdin;
+
+  if (optind < argc) {
+    in = fopen(argv[optind], "r");
+
+    if (in == NULL) {
+      perror(argv[optind]);
+      return 1;
+    }
+  }
+
+  int ok = parse_cgf_from_file(in, &opts);
+
+  if (in != stdin) {
+    fclose(in);
+  }
+
+  if (opts.binaryOutput != NULL) {
+    fclose(opts.binaryOutput);
+  }
+
+  if (opts.outputFd != STDOUT_FILENO) {
+    close(opts.outputFd);
+  }
+
+  return ok ? 0 : 1;
+}
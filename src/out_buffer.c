@@ -0,0 +1,127 @@
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/out_buffer.h"
+
+const char outBufferDigitPairs[200] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static void out_buffer_write_sink(OutBuffer *out, const char *s, size_t n);
+
+void out_buffer_init(OutBuffer *out, int fd, FILE *file) {
+  out->data = NULL;
+  out->size = 0;
+  out->capacity = 0;
+  out->fd = fd;
+  out->file = file;
+  out->failed = 0;
+}
+
+void out_buffer_set_sink(OutBuffer *out, int fd, FILE *file) {
+  out_buffer_flush(out);
+  out->fd = fd;
+  out->file = file;
+}
+
+int out_buffer_flush(OutBuffer *out) {
+  if ((out->fd != -1 || out->file != NULL) && out->size > 0) {
+    out_buffer_write_sink(out, out->data, out->size);
+    out->size = 0;
+  }
+
+  return !out->failed;
+}
+
+char *out_buffer_detach(OutBuffer *out, size_t *size) {
+  char *data = out->data;
+
+  *size = out->size;
+  out->data = NULL;
+  out->size = 0;
+  out->capacity = 0;
+  return data;
+}
+
+void out_buffer_release(OutBuffer *out) {
+  out_buffer_flush(out);
+  free(out->data);
+  out->data = NULL;
+  out->size = 0;
+  out->capacity = 0;
+}
+
+void out_buffer_write_slow(OutBuffer *out, const char *s, size_t n) {
+  if (out->fd != -1 || out->file != NULL) {
+    size_t flushSize = out->fd != -1
+      ? OUT_BUFFER_FLUSH_SIZE : OUT_BUFFER_FILE_FLUSH_SIZE;
+
+    out_buffer_flush(out);
+
+    // Copying a buffer's worth of bytes or more gains nothing.
+    if (n >= flushSize) {
+      out_buffer_write_sink(out, s, n);
+      return;
+    }
+
+    // The buffer is empty, so it need not be copied when it is replaced.
+    if (out->capacity < flushSize) {
+      free(out->data);
+      out->capacity = flushSize;
+      out->data = malloc(out->capacity);
+      assert(out->data != NULL && "Ran out of virtual memory\n");
+    }
+  } else {
+    size_t capacity = out->capacity > 0 ? 2 * out->capacity
+      : OUT_BUFFER_MIN_SIZE;
+
+    if (capacity < out->size + n) {
+      capacity = out->size + n;
+    }
+
+    out->data = realloc(out->data, capacity);
+    assert(out->data != NULL && "Ran out of virtual memory\n");
+    out->capacity = capacity;
+  }
+
+  memcpy(out->data + out->size, s, n);
+  out->size += n;
+}
+
+/// Writes the n bytes at s to the sink of out, retrying short writes.
+static void out_buffer_write_sink(OutBuffer *out, const char *s, size_t n) {
+  if (out->failed) {
+    return;
+  }
+
+  if (out->fd == -1) {
+    out->failed = fwrite(s, 1, n, out->file) != n;
+    return;
+  }
+
+  while (n > 0) {
+    ssize_t written = write(out->fd, s, n);
+
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      out->failed = 1;
+      return;
+    }
+
+    s += written;
+    n -= written;
+  }
+}
@@ -0,0 +1,171 @@
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPEC_SCAN_HAS_X86_KERNELS 1
+#endif
+
+#include "../include/spec_scan.h"
+
+typedef void (*SpecClassifyFn)(const char *, SpecBlockMasks *);
+
+static void spec_classify_block_scalar(const char *block,
+                                       SpecBlockMasks *masks);
+static void spec_scan_select_impl(void) __attribute__((constructor));
+
+// The kernel used by spec_classify_block. It starts out as the scalar one
+// and is switched to the widest vector kernel the CPU supports at program
+// startup.
+static SpecScanImpl currentImpl = SPEC_SCAN_IMPL_SCALAR;
+static SpecClassifyFn classifyKernel = spec_classify_block_scalar;
+
+void spec_classify_block(const char *block, SpecBlockMasks *masks) {
+  classifyKernel(block, masks);
+}
+
+static void spec_classify_block_scalar(const char *block,
+                                       SpecBlockMasks *masks) {
+  masks->idChars = 0;
+  masks->minuses = 0;
+  masks->newlines = 0;
+  masks->comments = 0;
+
+  for (int i=0 ; i<SPEC_BLOCK_SIZE ; i++) {
+    char c = block[i];
+    uint64_t bit = (uint64_t)1 << i;
+
+    if ((unsigned)(c - '0') < 10) {
+      masks->idChars |= bit;
+    } else if (c == '-') {
+      masks->idChars |= bit;
+      masks->minuses |= bit;
+    } else if (c == '\n') {
+      masks->newlines |= bit;
+    } else if (c == '!') {
+      masks->comments |= bit;
+    }
+  }
+}
+
+#ifdef SPEC_SCAN_HAS_X86_KERNELS
+
+// Digits are found with an unsigned range check: c - '0' is at most 9 for
+// digits only, and min(x, 9) == x tests that without a signed compare.
+
+__attribute__((target("avx2")))
+static uint32_t spec_movemask_digits_avx2(__m256i bytes) {
+  __m256i offsets = _mm256_sub_epi8(bytes, _mm256_set1_epi8('0'));
+  __m256i digits = _mm256_cmpeq_epi8(
+    _mm256_min_epu8(offsets, _mm256_set1_epi8(9)), offsets);
+  return (uint32_t)_mm256_movemask_epi8(digits);
+}
+
+__attribute__((target("avx2")))
+static uint32_t spec_movemask_eq_avx2(__m256i bytes, char c) {
+  __m256i matches = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c));
+  return (uint32_t)_mm256_movemask_epi8(matches);
+}
+
+__attribute__((target("avx2")))
+static void spec_classify_block_avx2(const char *block,
+                                     SpecBlockMasks *masks) {
+  __m256i lo = _mm256_loadu_si256((const __m256i *)block);
+  __m256i hi = _mm256_loadu_si256((const __m256i *)(block + 32));
+
+  masks->minuses = spec_movemask_eq_avx2(lo, '-')
+    | (uint64_t)spec_movemask_eq_avx2(hi, '-') << 32;
+  masks->idChars = masks->minuses | spec_movemask_digits_avx2(lo)
+    | (uint64_t)spec_movemask_digits_avx2(hi) << 32;
+  masks->newlines = spec_movemask_eq_avx2(lo, '\n')
+    | (uint64_t)spec_movemask_eq_avx2(hi, '\n') << 32;
+  masks->comments = spec_movemask_eq_avx2(lo, '!')
+    | (uint64_t)spec_movemask_eq_avx2(hi, '!') << 32;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void spec_classify_block_avx512(const char *block,
+                                       SpecBlockMasks *masks) {
+  __m512i bytes = _mm512_loadu_si512(block);
+  __m512i offsets = _mm512_sub_epi8(bytes, _mm512_set1_epi8('0'));
+
+  masks->minuses = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('-'));
+  masks->idChars = masks->minuses
+    | _mm512_cmple_epu8_mask(offsets, _mm512_set1_epi8(9));
+  masks->newlines = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('\n'));
+  masks->comments = _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8('!'));
+}
+
+#endif
+
+int spec_scan_impl_supported(SpecScanImpl impl) {
+  switch (impl) {
+  case SPEC_SCAN_IMPL_SCALAR:
+    return 1;
+#ifdef SPEC_SCAN_HAS_X86_KERNELS
+  case SPEC_SCAN_IMPL_AVX2:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+  case SPEC_SCAN_IMPL_AVX512:
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f")
+      && __builtin_cpu_supports("avx512bw");
+#else
+  default:
+    return 0;
+#endif
+  }
+
+  return 0;
+}
+
+int spec_scan_use_impl(SpecScanImpl impl) {
+  if (!spec_scan_impl_supported(impl)) {
+    return 0;
+  }
+
+  switch (impl) {
+  case SPEC_SCAN_IMPL_SCALAR:
+    classifyKernel = spec_classify_block_scalar;
+    break;
+#ifdef SPEC_SCAN_HAS_X86_KERNELS
+  case SPEC_SCAN_IMPL_AVX2:
+    classifyKernel = spec_classify_block_avx2;
+    break;
+  case SPEC_SCAN_IMPL_AVX512:
+    classifyKernel = spec_classify_block_avx512;
+    break;
+#else
+  default:
+    return 0;
+#endif
+  }
+
+  currentImpl = impl;
+  return 1;
+}
+
+SpecScanImpl spec_scan_current_impl(void) {
+  return currentImpl;
+}
+
+const char *spec_scan_impl_name(SpecScanImpl impl) {
+  switch (impl) {
+  case SPEC_SCAN_IMPL_SCALAR:
+    return "scalar";
+  case SPEC_SCAN_IMPL_AVX2:
+    return "avx2";
+  case SPEC_SCAN_IMPL_AVX512:
+    return "avx512";
+  }
+
+  return "unknown";
+}
+
+/// Picks the widest kernel supported by the CPU (as reported by CPUID).
+static void spec_scan_select_impl(void) {
+  if (!spec_scan_use_impl(SPEC_SCAN_IMPL_AVX512)) {
+    if (!spec_scan_use_impl(SPEC_SCAN_IMPL_AVX2)) {
+      spec_scan_use_impl(SPEC_SCAN_IMPL_SCALAR);
+    }
+  }
+}